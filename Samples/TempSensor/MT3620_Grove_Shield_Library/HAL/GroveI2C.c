@@ -3,40 +3,76 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <sys/uio.h>
 #include "GroveUART.h"
+#include "GroveI2CDev.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // SC18IM700
 
-static void wait_for_i2cState_ok(int fd)
+// Largest I2C frame the one-byte length field can describe; longer writes are split
+#define SC18IM700_MAX_FRAME		255
+
+// Per thread, so the difference across a call counts that call's polls even while other threads use the bridge
+static _Thread_local uint32_t statusPolls;
+
+// Polls I2CStat while the bridge reports busy; NACK and timeout are final, as is a bridge that stops answering
+static bool wait_for_i2cState_ok(int fd, uint8_t i2cState)
 {
-	uint8_t i2cState;
-	SC18IM700_ReadReg(fd, 0x0A, &i2cState);
-	while (i2cState != I2C_OK)
+	while (i2cState == I2C_BUSY)
 	{
-		SC18IM700_ReadReg(fd, 0x0A, &i2cState);
+		statusPolls++;
+		if (!SC18IM700_ReadReg(fd, 0x0A, &i2cState)) return false;
 	}
+
+	return i2cState == I2C_OK;
 }
 
-static void SC18IM700_I2cWrite(int fd, uint8_t address, const uint8_t* data, int dataSize)
-{	
-	// Send
-	uint8_t send[3 + dataSize + 1];
+// Each frame carries prefix + data chunk; the prefix (a control byte) is repeated at the top of every frame
+static bool SC18IM700_I2cWritePrefixed(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize)
+{
+	// Stop, then the first I2CStat poll in the same writev()
+	static const uint8_t trailer[4] = { 'P', 'R', 0x0A, 'P' };
+	int chunkMax = SC18IM700_MAX_FRAME - prefixSize;
 
-	send[0] = 'S';
-	send[1] = address & 0xfe;
-	send[2] = (uint8_t)dataSize;
-	memcpy(&send[3], data, (size_t)dataSize);
-	send[3 + dataSize] = 'P';
+	do
+	{
+		int chunk = dataSize < chunkMax ? dataSize : chunkMax;
+
+		// Send
+		uint8_t header[3] = { 'S', (uint8_t)(address & 0xfe), (uint8_t)(prefixSize + chunk) };
+		struct iovec iov[4] =
+		{
+			{ header, sizeof(header) },
+			{ (void*)prefix, (size_t)prefixSize },
+			{ (void*)data, (size_t)chunk },
+			{ (void*)trailer, sizeof(trailer) },
+		};
+		if (!GroveUART_WriteV(fd, iov, 4)) return false;
+
+		// wait for I2C state OK; a NACKed chunk ends the write
+		uint8_t i2cState;
+		statusPolls++;
+		if (!GroveUART_Read(fd, &i2cState, 1)) return false;
+		if (!wait_for_i2cState_ok(fd, i2cState)) return false;
+
+		data += chunk;
+		dataSize -= chunk;
+	} while (dataSize > 0);
 
-	GroveUART_Write(fd, send, (int)sizeof(send));
+	return true;
+}
 
-	// wait for I2C state OK
-	wait_for_i2cState_ok(fd);
+static bool SC18IM700_I2cWrite(int fd, uint8_t address, const uint8_t* data, int dataSize)
+{
+	return SC18IM700_I2cWritePrefixed(fd, address, NULL, 0, data, dataSize);
 }
 
 static bool SC18IM700_I2cRead(int fd, uint8_t address, uint8_t* data, int dataSize)
 {
+	// A read is one frame, its length a single byte
+	if (dataSize < 1 || dataSize > SC18IM700_MAX_FRAME) return false;
+
 	// Send
 
 	uint8_t send[4];
@@ -46,7 +82,7 @@ static bool SC18IM700_I2cRead(int fd, uint8_t address, uint8_t* data, int dataSi
 	send[2] = (uint8_t)dataSize;
 	send[3] = 'P';
 
-	GroveUART_Write(fd, send, sizeof(send));
+	if (!GroveUART_Write(fd, send, sizeof(send))) return false;
 
 	// Receive
 
@@ -55,6 +91,30 @@ static bool SC18IM700_I2cRead(int fd, uint8_t address, uint8_t* data, int dataSi
 	return true;
 }
 
+static bool SC18IM700_I2cWriteRead(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize)
+{
+	if (writeSize < 1 || writeSize > SC18IM700_MAX_FRAME || readSize < 1 || readSize > SC18IM700_MAX_FRAME) return false;
+
+	// Send: write, repeated start, read, stop in a single bridge command
+
+	uint8_t header[3] = { 'S', (uint8_t)(address & 0xfe), (uint8_t)writeSize };
+	uint8_t trailer[4] = { 'S', (uint8_t)(address | 0x01), (uint8_t)readSize, 'P' };
+	struct iovec iov[3] =
+	{
+		{ header, sizeof(header) },
+		{ (void*)writeData, (size_t)writeSize },
+		{ trailer, sizeof(trailer) },
+	};
+
+	if (!GroveUART_WriteV(fd, iov, 3)) return false;
+
+	// Receive
+
+	if (!GroveUART_Read(fd, readData, readSize)) return false;
+
+	return true;
+}
+
 bool SC18IM700_ReadReg(int fd, uint8_t reg, uint8_t* data)
 {
 	// Send
@@ -65,7 +125,7 @@ bool SC18IM700_ReadReg(int fd, uint8_t reg, uint8_t* data)
 	send[1] = reg;
 	send[2] = 'P';
 	
-	GroveUART_Write(fd, send, 3);
+	if (!GroveUART_Write(fd, send, 3)) return false;
 
 	// Receive
 
@@ -87,48 +147,73 @@ void SC18IM700_WriteReg(int fd, uint8_t reg, uint8_t data)
 	GroveUART_Write(fd, send, (int)sizeof(send));
 }
 
-void SC18IM700_WriteRegBytes(int fd, uint8_t *data, uint8_t dataSize)
+uint32_t SC18IM700_GetStatusPolls(void)
 {
-	// Send
+	return statusPolls;
+}
 
-	uint8_t send[2 + dataSize];
+bool SC18IM700_WriteRegBytes(int fd, const uint8_t *data, int dataSize)
+{
+	// Send
 
-	send[0] = 'W';
-	memcpy(&send[1], data, (uint8_t)dataSize);
-	send[dataSize+1] = 'P';
+	static const uint8_t header = 'W';
+	static const uint8_t trailer = 'P';
+	struct iovec iov[3] =
+	{
+		{ (void*)&header, 1 },
+		{ (void*)data, (size_t)dataSize },
+		{ (void*)&trailer, 1 },
+	};
 
-	GroveUART_Write(fd, send, (uint8_t)(dataSize+2));
+	return GroveUART_WriteV(fd, iov, 3);
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // GroveI2C
 
-void(*GroveI2C_Write)(int fd, uint8_t address, const uint8_t* data, int dataSize) = SC18IM700_I2cWrite;
+bool(*GroveI2C_Write)(int fd, uint8_t address, const uint8_t* data, int dataSize) = SC18IM700_I2cWrite;
 bool(*GroveI2C_Read)(int fd, uint8_t address, uint8_t* data, int dataSize) = SC18IM700_I2cRead;
+bool(*GroveI2C_WriteRead)(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize) = SC18IM700_I2cWriteRead;
+bool(*GroveI2C_WritePrefixed)(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize) = SC18IM700_I2cWritePrefixed;
+
+void GroveI2C_SelectBackend(GroveI2C_Backend backend)
+{
+	switch (backend)
+	{
+	case GroveI2C_Backend_I2cDev:
+		GroveI2C_Write = GroveI2CDev_Write;
+		GroveI2C_Read = GroveI2CDev_Read;
+		GroveI2C_WriteRead = GroveI2CDev_WriteRead;
+		GroveI2C_WritePrefixed = GroveI2CDev_WritePrefixed;
+		break;
+	case GroveI2C_Backend_SC18IM700:
+	default:
+		GroveI2C_Write = SC18IM700_I2cWrite;
+		GroveI2C_Read = SC18IM700_I2cRead;
+		GroveI2C_WriteRead = SC18IM700_I2cWriteRead;
+		GroveI2C_WritePrefixed = SC18IM700_I2cWritePrefixed;
+		break;
+	}
+}
 
-void GroveI2C_WriteReg8(int fd, uint8_t address, uint8_t reg, uint8_t val)
+bool GroveI2C_WriteReg8(int fd, uint8_t address, uint8_t reg, uint8_t val)
 {
 	uint8_t send[2];
 	send[0] = reg;
 	send[1] = val;
-	GroveI2C_Write(fd, address, send, sizeof(send));
+	return GroveI2C_Write(fd, address, send, sizeof(send));
 }
 
-void GroveI2C_WriteBytes(int fd, uint8_t address, uint8_t *data, uint8_t dataSize)
+bool GroveI2C_WriteBytes(int fd, uint8_t address, const uint8_t *data, int dataSize)
 {
-	uint8_t send[dataSize];
-	memcpy(send, data, dataSize);
-
-	GroveI2C_Write(fd, address, send, (int)sizeof(send));
+	return GroveI2C_Write(fd, address, data, dataSize);
 }
 
 bool GroveI2C_ReadReg8(int fd, uint8_t address, uint8_t reg, uint8_t* val)
 {
-	GroveI2C_Write(fd, address, &reg, 1);
-
 	uint8_t recv[1];
-	if (!GroveI2C_Read(fd, address, recv, sizeof(recv))) return false;
+	if (!GroveI2C_WriteRead(fd, address, &reg, 1, recv, sizeof(recv))) return false;
 
 	*val = recv[0];
 
@@ -137,10 +222,8 @@ bool GroveI2C_ReadReg8(int fd, uint8_t address, uint8_t reg, uint8_t* val)
 
 bool GroveI2C_ReadReg16(int fd, uint8_t address, uint8_t reg, uint16_t* val)
 {
-	GroveI2C_Write(fd, address, &reg, 1);
-
 	uint8_t recv[2];
-	if (!GroveI2C_Read(fd, address, recv, sizeof(recv))) return false;
+	if (!GroveI2C_WriteRead(fd, address, &reg, 1, recv, sizeof(recv))) return false;
 
 	*val = (uint16_t)(recv[1] << 8 | recv[0]);
 
@@ -149,10 +232,8 @@ bool GroveI2C_ReadReg16(int fd, uint8_t address, uint8_t reg, uint16_t* val)
 
 bool GroveI2C_ReadReg24BE(int fd, uint8_t address, uint8_t reg, uint32_t* val)
 {
-	GroveI2C_Write(fd, address, &reg, 1);
-
 	uint8_t recv[3];
-	if (!GroveI2C_Read(fd, address, recv, sizeof(recv))) return false;
+	if (!GroveI2C_WriteRead(fd, address, &reg, 1, recv, sizeof(recv))) return false;
 
 	*val = (uint32_t)(recv[0] << 16 | recv[1] << 8 | recv[2]);
 
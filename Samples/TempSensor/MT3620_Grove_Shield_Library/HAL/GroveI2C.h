@@ -8,17 +8,39 @@
 #define I2C_OK								0xF0
 #define I2C_NACK_ON_ADDRESS		0xF1
 #define I2C_NACK_ON_DATA			0xF2
+#define I2C_BUSY							0xF3
 #define I2C_TIME_OUT					0xF8
 
 bool SC18IM700_ReadReg(int fd, uint8_t reg, uint8_t* data);
 void SC18IM700_WriteReg(int fd, uint8_t reg, uint8_t data);
-void SC18IM700_WriteRegBytes(int fd, uint8_t *data, uint8_t dataSize);
+// Register/value pairs in one 'W' command; false if the command could not be sent
+bool SC18IM700_WriteRegBytes(int fd, const uint8_t *data, int dataSize);
 
-void(*GroveI2C_Write)(int fd, uint8_t address, const uint8_t* data, int dataSize);
-bool(*GroveI2C_Read)(int fd, uint8_t address, uint8_t* data, int dataSize);
+// I2CStat reads the calling thread has issued while waiting for its writes to complete
+uint32_t SC18IM700_GetStatusPolls(void);
 
-void GroveI2C_WriteReg8(int fd, uint8_t address, uint8_t reg, uint8_t val);
-void GroveI2C_WriteBytes(int fd, uint8_t address, uint8_t *data, uint8_t dataSize);
+typedef enum
+{
+	GroveI2C_Backend_SC18IM700,		// Grove shield UART-to-I2C bridge
+	GroveI2C_Backend_I2cDev			// Linux /dev/i2c-N (see GroveI2CDev.h)
+}
+GroveI2C_Backend;
+
+extern bool(*GroveI2C_Write)(int fd, uint8_t address, const uint8_t* data, int dataSize);
+// Reads are a single transaction; the SC18IM700 takes 1 to 255 bytes per direction and refuses anything else.
+extern bool(*GroveI2C_Read)(int fd, uint8_t address, uint8_t* data, int dataSize);
+extern bool(*GroveI2C_WriteRead)(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize);
+
+// Writes prefix + data without copying either. Payloads longer than one frame (255 bytes on the SC18IM700) are
+// split into several write transactions, each starting with the same prefix, so prefix must be a control byte that
+// means the same at the top of every transaction (e.g. the OLED's 0x00 command / 0x40 data byte). A register address
+// is not: the device would restart each chunk at that register. GroveI2C_Write splits the same way with no prefix.
+extern bool(*GroveI2C_WritePrefixed)(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize);
+
+void GroveI2C_SelectBackend(GroveI2C_Backend backend);
+
+bool GroveI2C_WriteReg8(int fd, uint8_t address, uint8_t reg, uint8_t val);
+bool GroveI2C_WriteBytes(int fd, uint8_t address, const uint8_t *data, int dataSize);
 
 bool GroveI2C_ReadReg8(int fd, uint8_t address, uint8_t reg, uint8_t* val);
 bool GroveI2C_ReadReg16(int fd, uint8_t address, uint8_t reg, uint16_t* val);
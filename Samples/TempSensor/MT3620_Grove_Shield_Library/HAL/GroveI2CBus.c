@@ -0,0 +1,321 @@
+#include "GroveI2CBus.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "GroveI2C.h"
+
+#define GROVE_I2C_BUS_MAX	4
+
+typedef struct
+{
+	bool InUse;
+	int Fd;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Released;
+	pthread_t Owner;
+	int Depth;									// nesting count of the owner, 0 when the bus is free
+	int Waiting[GroveI2CBus_Priority_Count];
+	uint8_t Priorities[128];					// by 7-bit address
+	GroveI2CBusStats Stats;
+}
+GroveI2CBusInstance;
+
+static GroveI2CBusInstance buses[GROVE_I2C_BUS_MAX];
+static int busCount;
+static pthread_mutex_t tableMutex = PTHREAD_MUTEX_INITIALIZER;	// buses[], busCount and the hook below
+
+// The backend functions the arbiter wraps. Once hooked the wrappers stay in the chain until they are on top of it
+// again, so a tracer enabled after the first bus is never unhooked by the last close.
+static bool hooked;
+static bool(*inner_write)(int fd, uint8_t address, const uint8_t* data, int dataSize);
+static bool(*inner_read)(int fd, uint8_t address, uint8_t* data, int dataSize);
+static bool(*inner_write_read)(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize);
+static bool(*inner_write_prefixed)(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize);
+
+////////////////////////////////////////////////////////////////////////////////
+// Lock
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static GroveI2CBusInstance* find_bus(int fd)
+{
+	for (int i = 0; i < GROVE_I2C_BUS_MAX; i++)
+	{
+		if (buses[i].InUse && buses[i].Fd == fd) return &buses[i];
+	}
+	return NULL;
+}
+
+// Looks fd up and returns its bus with the bus mutex held. Taking it under the table lock means a caller is the
+// owner or a counted waiter before Close can look at the bus.
+static GroveI2CBusInstance* find_bus_locked(int fd)
+{
+	pthread_mutex_lock(&tableMutex);
+	GroveI2CBusInstance* this = find_bus(fd);
+	if (this != NULL) pthread_mutex_lock(&this->Mutex);
+	pthread_mutex_unlock(&tableMutex);
+
+	return this;
+}
+
+static bool higher_waiting(const GroveI2CBusInstance* this, int priority)
+{
+	for (int p = priority + 1; p < GroveI2CBus_Priority_Count; p++)
+	{
+		if (this->Waiting[p] > 0) return true;
+	}
+	return false;
+}
+
+// Called with this->Mutex held (find_bus_locked); returns with the bus owned and the mutex released
+static void bus_lock(GroveI2CBusInstance* this, int priority, bool transaction)
+{
+	if (transaction) this->Stats.Transactions++;
+
+	pthread_t self = pthread_self();
+	if (this->Depth > 0 && pthread_equal(this->Owner, self))
+	{
+		this->Depth++;
+		pthread_mutex_unlock(&this->Mutex);
+		return;
+	}
+
+	GroveI2CBusLockStats* stats = &this->Stats.Priority[priority];
+	if (this->Depth > 0 || higher_waiting(this, priority))
+	{
+		uint64_t start = now_ns();
+
+		this->Waiting[priority]++;
+		while (this->Depth > 0 || higher_waiting(this, priority))
+		{
+			pthread_cond_wait(&this->Released, &this->Mutex);
+		}
+		this->Waiting[priority]--;
+
+		uint64_t wait = now_ns() - start;
+		stats->Contended++;
+		stats->WaitNs += wait;
+		if (wait > stats->MaxWaitNs) stats->MaxWaitNs = wait;
+	}
+
+	stats->Acquisitions++;
+	this->Owner = self;
+	this->Depth = 1;
+
+	pthread_mutex_unlock(&this->Mutex);
+}
+
+static void bus_unlock(GroveI2CBusInstance* this)
+{
+	pthread_mutex_lock(&this->Mutex);
+
+	if (this->Depth > 0 && --this->Depth == 0)
+	{
+		// Every waiter re-checks; the highest priority one wins
+		pthread_cond_broadcast(&this->Released);
+	}
+
+	pthread_mutex_unlock(&this->Mutex);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Wrapped transactions
+
+static bool bus_write(int fd, uint8_t address, const uint8_t* data, int dataSize)
+{
+	GroveI2CBusInstance* this = find_bus_locked(fd);
+	if (this == NULL) return inner_write(fd, address, data, dataSize);
+
+	bus_lock(this, this->Priorities[address >> 1], true);
+	bool ok = inner_write(fd, address, data, dataSize);
+	bus_unlock(this);
+
+	return ok;
+}
+
+static bool bus_read(int fd, uint8_t address, uint8_t* data, int dataSize)
+{
+	GroveI2CBusInstance* this = find_bus_locked(fd);
+	if (this == NULL) return inner_read(fd, address, data, dataSize);
+
+	bus_lock(this, this->Priorities[address >> 1], true);
+	bool ok = inner_read(fd, address, data, dataSize);
+	bus_unlock(this);
+
+	return ok;
+}
+
+static bool bus_write_read(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize)
+{
+	GroveI2CBusInstance* this = find_bus_locked(fd);
+	if (this == NULL) return inner_write_read(fd, address, writeData, writeSize, readData, readSize);
+
+	bus_lock(this, this->Priorities[address >> 1], true);
+	bool ok = inner_write_read(fd, address, writeData, writeSize, readData, readSize);
+	bus_unlock(this);
+
+	return ok;
+}
+
+static bool bus_write_prefixed(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize)
+{
+	GroveI2CBusInstance* this = find_bus_locked(fd);
+	if (this == NULL) return inner_write_prefixed(fd, address, prefix, prefixSize, data, dataSize);
+
+	// All chunks of a split write go out under one lock
+	bus_lock(this, this->Priorities[address >> 1], true);
+	bool ok = inner_write_prefixed(fd, address, prefix, prefixSize, data, dataSize);
+	bus_unlock(this);
+
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GroveI2CBus
+
+void* GroveI2CBus_Open(int i2cFd)
+{
+	if (i2cFd < 0) return NULL;
+
+	pthread_mutex_lock(&tableMutex);
+
+	GroveI2CBusInstance* this = find_bus(i2cFd);
+	if (this != NULL)
+	{
+		pthread_mutex_unlock(&tableMutex);
+		return this;
+	}
+
+	for (int i = 0; i < GROVE_I2C_BUS_MAX && this == NULL; i++)
+	{
+		if (!buses[i].InUse) this = &buses[i];
+	}
+	if (this == NULL)
+	{
+		pthread_mutex_unlock(&tableMutex);
+		return NULL;
+	}
+
+	memset(this, 0, sizeof(*this));
+	this->Fd = i2cFd;
+	memset(this->Priorities, GroveI2CBus_Priority_Normal, sizeof(this->Priorities));
+	pthread_mutex_init(&this->Mutex, NULL);
+	pthread_cond_init(&this->Released, NULL);
+	this->InUse = true;
+
+	busCount++;
+	if (!hooked)
+	{
+		hooked = true;
+		inner_write = GroveI2C_Write;
+		inner_read = GroveI2C_Read;
+		inner_write_read = GroveI2C_WriteRead;
+		inner_write_prefixed = GroveI2C_WritePrefixed;
+		GroveI2C_Write = bus_write;
+		GroveI2C_Read = bus_read;
+		GroveI2C_WriteRead = bus_write_read;
+		GroveI2C_WritePrefixed = bus_write_prefixed;
+	}
+
+	pthread_mutex_unlock(&tableMutex);
+
+	return this;
+}
+
+bool GroveI2CBus_Close(void* inst)
+{
+	GroveI2CBusInstance* this = (GroveI2CBusInstance*)inst;
+	if (this == NULL) return false;
+
+	pthread_mutex_lock(&tableMutex);
+	if (!this->InUse)
+	{
+		pthread_mutex_unlock(&tableMutex);
+		return false;
+	}
+
+	// Nobody may hold or wait for the bus while its mutex and condition go away
+	pthread_mutex_lock(&this->Mutex);
+	bool busy = this->Depth > 0;
+	for (int p = 0; p < GroveI2CBus_Priority_Count; p++)
+	{
+		busy = busy || this->Waiting[p] > 0;
+	}
+	pthread_mutex_unlock(&this->Mutex);
+	if (busy)
+	{
+		pthread_mutex_unlock(&tableMutex);
+		return false;
+	}
+
+	this->InUse = false;
+	pthread_cond_destroy(&this->Released);
+	pthread_mutex_destroy(&this->Mutex);
+
+	// Unhook only from the top of the chain; further down the wrappers just pass calls through with no bus open
+	if (--busCount == 0 && GroveI2C_Write == bus_write && GroveI2C_Read == bus_read &&
+		GroveI2C_WriteRead == bus_write_read && GroveI2C_WritePrefixed == bus_write_prefixed)
+	{
+		GroveI2C_Write = inner_write;
+		GroveI2C_Read = inner_read;
+		GroveI2C_WriteRead = inner_write_read;
+		GroveI2C_WritePrefixed = inner_write_prefixed;
+		hooked = false;
+	}
+
+	pthread_mutex_unlock(&tableMutex);
+
+	return true;
+}
+
+void GroveI2CBus_SetDevicePriority(void* inst, uint8_t address, GroveI2CBus_Priority priority)
+{
+	GroveI2CBusInstance* this = (GroveI2CBusInstance*)inst;
+	if (this == NULL) return;
+	if (priority >= GroveI2CBus_Priority_Count) priority = GroveI2CBus_Priority_High;
+
+	// Transactions read the table under the bus mutex
+	pthread_mutex_lock(&this->Mutex);
+	this->Priorities[address >> 1] = (uint8_t)priority;
+	pthread_mutex_unlock(&this->Mutex);
+}
+
+void GroveI2CBus_Lock(int i2cFd, uint8_t address)
+{
+	GroveI2CBusInstance* this = find_bus_locked(i2cFd);
+	if (this != NULL) bus_lock(this, this->Priorities[address >> 1], false);
+}
+
+void GroveI2CBus_Unlock(int i2cFd)
+{
+	// The caller holds the bus, so Close leaves it alone
+	pthread_mutex_lock(&tableMutex);
+	GroveI2CBusInstance* this = find_bus(i2cFd);
+	pthread_mutex_unlock(&tableMutex);
+
+	if (this != NULL) bus_unlock(this);
+}
+
+void GroveI2CBus_GetStats(void* inst, GroveI2CBusStats* stats)
+{
+	GroveI2CBusInstance* this = (GroveI2CBusInstance*)inst;
+
+	pthread_mutex_lock(&this->Mutex);
+	*stats = this->Stats;
+	pthread_mutex_unlock(&this->Mutex);
+}
+
+void GroveI2CBus_ResetStats(void* inst)
+{
+	GroveI2CBusInstance* this = (GroveI2CBusInstance*)inst;
+
+	pthread_mutex_lock(&this->Mutex);
+	memset(&this->Stats, 0, sizeof(this->Stats));
+	pthread_mutex_unlock(&this->Mutex);
+}
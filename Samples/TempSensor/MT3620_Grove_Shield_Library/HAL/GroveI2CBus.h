@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../applibs_versions.h"
+
+// Bus arbiter: serializes complete I2C transactions on a shared fd between threads.
+// Opening a bus wraps the GroveI2C_Write/Read/WriteRead/WritePrefixed pointers, so drivers keep passing the plain fd
+// and every call on an arbitrated fd runs under the bus lock. Select the backend before opening the first bus.
+// A tracer may be enabled before or after the first bus; closing the last bus leaves a later tracer hooked.
+// Hooking and unhooking swap the pointers with plain stores, so open and close buses (and enable or disable the
+// tracer) while no other thread is making I2C calls: before the worker threads start and after they are joined.
+// GroveI2CBus_Lock/Unlock hold the bus across several calls (e.g. configure, convert, read back); both nest.
+
+typedef enum
+{
+	GroveI2CBus_Priority_Low,		// bulk transfers, e.g. display redraws
+	GroveI2CBus_Priority_Normal,
+	GroveI2CBus_Priority_High,		// latency sensitive sensor reads
+	GroveI2CBus_Priority_Count
+}
+GroveI2CBus_Priority;
+
+typedef struct
+{
+	uint32_t Acquisitions;
+	uint32_t Contended;			// acquisitions that had to wait
+	uint64_t WaitNs;			// total time spent waiting for the lock
+	uint64_t MaxWaitNs;
+}
+GroveI2CBusLockStats;
+
+typedef struct
+{
+	GroveI2CBusLockStats Priority[GroveI2CBus_Priority_Count];
+	uint32_t Transactions;		// GroveI2C calls run under the lock
+}
+GroveI2CBusStats;
+
+void* GroveI2CBus_Open(int i2cFd);
+// Fails, leaving the bus open, while a thread holds the bus or waits for it.
+bool GroveI2CBus_Close(void* inst);
+
+// Priority applied to transactions with a device; unset addresses run at GroveI2CBus_Priority_Normal.
+void GroveI2CBus_SetDevicePriority(void* inst, uint8_t address, GroveI2CBus_Priority priority);
+
+// A waiting thread of higher priority is always granted the bus before lower ones.
+void GroveI2CBus_Lock(int i2cFd, uint8_t address);
+void GroveI2CBus_Unlock(int i2cFd);
+
+void GroveI2CBus_GetStats(void* inst, GroveI2CBusStats* stats);
+void GroveI2CBus_ResetStats(void* inst);
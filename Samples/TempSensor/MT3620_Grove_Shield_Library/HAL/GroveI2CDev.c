@@ -0,0 +1,91 @@
+#include "GroveI2CDev.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+// Largest write transaction; matches the SC18IM700 frame limit so both backends split alike
+#define FRAME_SIZE		255
+
+static bool transfer(int fd, struct i2c_msg* msgs, int msgCount)
+{
+	struct i2c_rdwr_ioctl_data ioctlData;
+	ioctlData.msgs = msgs;
+	ioctlData.nmsgs = (uint32_t)msgCount;
+
+	return ioctl(fd, I2C_RDWR, &ioctlData) == msgCount;
+}
+
+int GroveI2CDev_Open(int busIndex)
+{
+	char path[20];
+	snprintf(path, sizeof(path), "/dev/i2c-%d", busIndex);
+
+	return open(path, O_RDWR);
+}
+
+static bool write_frame(int fd, uint8_t address, const uint8_t* data, int dataSize)
+{
+	struct i2c_msg msg = { .addr = (uint16_t)(address >> 1), .flags = 0, .len = (uint16_t)dataSize, .buf = (uint8_t*)data };
+
+	return transfer(fd, &msg, 1);
+}
+
+bool GroveI2CDev_Write(int fd, uint8_t address, const uint8_t* data, int dataSize)
+{
+	// One transaction per frame, each with its own STOP, as on the SC18IM700
+	do
+	{
+		int chunk = dataSize < FRAME_SIZE ? dataSize : FRAME_SIZE;
+		if (!write_frame(fd, address, data, chunk)) return false;
+
+		data += chunk;
+		dataSize -= chunk;
+	} while (dataSize > 0);
+
+	return true;
+}
+
+bool GroveI2CDev_WritePrefixed(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize)
+{
+	if (prefixSize == 0) return GroveI2CDev_Write(fd, address, data, dataSize);
+
+	// Plain i2c_msgs cannot be glued without a repeated start, so the prefix is copied in front of each chunk
+	uint8_t frame[FRAME_SIZE];
+	int chunkMax = FRAME_SIZE - prefixSize;
+	memcpy(frame, prefix, (size_t)prefixSize);
+
+	do
+	{
+		int chunk = dataSize < chunkMax ? dataSize : chunkMax;
+		memcpy(&frame[prefixSize], data, (size_t)chunk);
+		if (!write_frame(fd, address, frame, prefixSize + chunk)) return false;
+
+		data += chunk;
+		dataSize -= chunk;
+	} while (dataSize > 0);
+
+	return true;
+}
+
+bool GroveI2CDev_Read(int fd, uint8_t address, uint8_t* data, int dataSize)
+{
+	struct i2c_msg msg = { .addr = (uint16_t)(address >> 1), .flags = I2C_M_RD, .len = (uint16_t)dataSize, .buf = data };
+
+	return transfer(fd, &msg, 1);
+}
+
+bool GroveI2CDev_WriteRead(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize)
+{
+	// One ioctl, repeated start between the two messages, single STOP at the end
+	struct i2c_msg msgs[2] =
+	{
+		{ .addr = (uint16_t)(address >> 1), .flags = 0, .len = (uint16_t)writeSize, .buf = (uint8_t*)writeData },
+		{ .addr = (uint16_t)(address >> 1), .flags = I2C_M_RD, .len = (uint16_t)readSize, .buf = readData },
+	};
+
+	return transfer(fd, msgs, 2);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Native Linux i2c-dev backend: talks to /dev/i2c-N with I2C_RDWR instead of going through the SC18IM700.
+// Addresses follow the rest of the library (8-bit, R/W bit in bit 0). Writes are split into transactions of at most
+// 255 bytes, exactly as on the SC18IM700 (see GroveI2C_WritePrefixed).
+
+int GroveI2CDev_Open(int busIndex);
+
+bool GroveI2CDev_Write(int fd, uint8_t address, const uint8_t* data, int dataSize);
+bool GroveI2CDev_Read(int fd, uint8_t address, uint8_t* data, int dataSize);
+bool GroveI2CDev_WritePrefixed(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize);
+bool GroveI2CDev_WriteRead(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize);
@@ -0,0 +1,383 @@
+#include "GroveI2CTrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "GroveI2C.h"
+
+#include <applibs/log.h>
+
+#define TRACE_MAX_DEVICES	16
+
+// Latency histogram: 4 linear steps per power of two, so a bucket is at most 25 % wide
+#define TRACE_BUCKETS		128
+
+typedef struct
+{
+	GroveI2CTraceDeviceStats Stats;
+	uint32_t Buckets[TRACE_BUCKETS];
+}
+TraceDevice;
+
+static bool enabled;
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static TraceDevice* devices;
+static int deviceCount;
+static FILE* capture;
+static uint32_t captureLost;
+static uint64_t startUs;
+static uint64_t summaryUs;
+static uint64_t lastSummaryUs;
+
+// The backend functions the tracer wraps. Disable only unhooks the tracer from the top of the chain; below a bus
+// arbiter opened later the wrappers stay and pass calls through untraced.
+static bool hooked;
+static bool(*inner_write)(int fd, uint8_t address, const uint8_t* data, int dataSize);
+static bool(*inner_read)(int fd, uint8_t address, uint8_t* data, int dataSize);
+static bool(*inner_write_read)(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize);
+static bool(*inner_write_prefixed)(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize);
+
+////////////////////////////////////////////////////////////////////////////////
+// Accounting
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int bucket_of(uint32_t us)
+{
+	if (us < 4) return (int)us;
+
+	int e = 31 - __builtin_clz(us);
+	return 4 * (e - 1) + (int)((us >> (e - 2)) & 3);
+}
+
+static uint32_t bucket_upper(int bucket)
+{
+	if (bucket < 4) return (uint32_t)bucket;
+
+	int e = bucket / 4 + 1;
+	uint32_t lower = (uint32_t)(4 + bucket % 4) << (e - 2);
+	return lower + (1u << (e - 2)) - 1;
+}
+
+static uint32_t percentile(const TraceDevice* dev, uint32_t permille)
+{
+	uint64_t target = ((uint64_t)dev->Stats.Transactions * permille + 999) / 1000;
+	uint64_t seen = 0;
+	for (int i = 0; i < TRACE_BUCKETS; i++)
+	{
+		seen += dev->Buckets[i];
+		if (seen >= target && seen > 0)
+		{
+			// The bucket's upper bound can lie past the slowest transaction actually seen
+			uint32_t upper = bucket_upper(i);
+			return upper < dev->Stats.MaxUs ? upper : dev->Stats.MaxUs;
+		}
+	}
+	return 0;
+}
+
+static TraceDevice* find_device(uint8_t address)
+{
+	address &= 0xfe;
+	for (int i = 0; i < deviceCount; i++)
+	{
+		if (devices[i].Stats.Address == address) return &devices[i];
+	}
+	if (deviceCount == TRACE_MAX_DEVICES) return NULL;
+
+	TraceDevice* dev = &devices[deviceCount++];
+	memset(dev, 0, sizeof(*dev));
+	dev->Stats.Address = address;
+	return dev;
+}
+
+static void write_u16(uint8_t* p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_u32(uint8_t* p, uint32_t v)
+{
+	write_u16(p, (uint16_t)v);
+	write_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void log_summary_locked(uint64_t now);
+
+static void record(uint8_t address, GroveI2CTrace_Op op, bool ok, uint64_t start, uint32_t polls,
+	const uint8_t* prefix, int prefixSize, const uint8_t* writeData, int writeSize, const uint8_t* readData, int readSize)
+{
+	uint64_t end = now_us();
+	uint32_t latency = (uint32_t)(end - start);
+
+	pthread_mutex_lock(&traceMutex);
+	if (!enabled)
+	{
+		pthread_mutex_unlock(&traceMutex);
+		return;
+	}
+
+	TraceDevice* dev = find_device(address);
+	if (dev != NULL)
+	{
+		GroveI2CTraceDeviceStats* s = &dev->Stats;
+		s->Transactions++;
+		if (!ok) s->Failures++;
+		s->BytesWritten += (uint64_t)(prefixSize + writeSize);
+		if (ok) s->BytesRead += (uint64_t)readSize;
+		s->StatusPolls += polls;
+		s->BusUs += latency;
+		if (latency > s->MaxUs) s->MaxUs = latency;
+		dev->Buckets[bucket_of(latency)]++;
+	}
+
+	if (capture != NULL)
+	{
+		uint8_t header[16];
+		write_u32(&header[0], (uint32_t)(start - startUs));
+		write_u32(&header[4], latency);
+		header[8] = address;
+		header[9] = (uint8_t)op;
+		header[10] = ok ? 1 : 0;
+		header[11] = (uint8_t)(polls > 0xff ? 0xff : polls);
+		write_u16(&header[12], (uint16_t)(prefixSize + writeSize));
+		write_u16(&header[14], (uint16_t)(ok ? readSize : 0));
+
+		bool written = fwrite(header, 1, sizeof(header), capture) == sizeof(header);
+		if (written && prefixSize > 0) written = fwrite(prefix, 1, (size_t)prefixSize, capture) == (size_t)prefixSize;
+		if (written && writeSize > 0) written = fwrite(writeData, 1, (size_t)writeSize, capture) == (size_t)writeSize;
+		if (written && ok && readSize > 0) written = fwrite(readData, 1, (size_t)readSize, capture) == (size_t)readSize;
+
+		// A short write leaves a torn record, so the capture ends there; the statistics go on
+		if (!written)
+		{
+			fclose(capture);
+			capture = NULL;
+			captureLost++;
+			Log_Debug("[error] I2C trace capture stopped, write failed.\n");
+		}
+	}
+	else if (captureLost > 0)
+	{
+		captureLost++;
+	}
+
+	if (summaryUs > 0 && end - lastSummaryUs >= summaryUs)
+	{
+		log_summary_locked(end);
+	}
+
+	pthread_mutex_unlock(&traceMutex);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Wrapped transactions
+
+static bool trace_write(int fd, uint8_t address, const uint8_t* data, int dataSize)
+{
+	uint32_t polls = SC18IM700_GetStatusPolls();
+	uint64_t start = now_us();
+
+	bool ok = inner_write(fd, address, data, dataSize);
+
+	record(address, GroveI2CTrace_Op_Write, ok, start, SC18IM700_GetStatusPolls() - polls, NULL, 0, data, dataSize, NULL, 0);
+	return ok;
+}
+
+static bool trace_read(int fd, uint8_t address, uint8_t* data, int dataSize)
+{
+	uint64_t start = now_us();
+
+	bool ok = inner_read(fd, address, data, dataSize);
+
+	record(address, GroveI2CTrace_Op_Read, ok, start, 0, NULL, 0, NULL, 0, data, dataSize);
+	return ok;
+}
+
+static bool trace_write_read(int fd, uint8_t address, const uint8_t* writeData, int writeSize, uint8_t* readData, int readSize)
+{
+	uint64_t start = now_us();
+
+	bool ok = inner_write_read(fd, address, writeData, writeSize, readData, readSize);
+
+	record(address, GroveI2CTrace_Op_WriteRead, ok, start, 0, NULL, 0, writeData, writeSize, readData, readSize);
+	return ok;
+}
+
+static bool trace_write_prefixed(int fd, uint8_t address, const uint8_t* prefix, int prefixSize, const uint8_t* data, int dataSize)
+{
+	uint32_t polls = SC18IM700_GetStatusPolls();
+	uint64_t start = now_us();
+
+	bool ok = inner_write_prefixed(fd, address, prefix, prefixSize, data, dataSize);
+
+	// One record for the whole call; a split write shows up as its summed size
+	record(address, GroveI2CTrace_Op_Write, ok, start, SC18IM700_GetStatusPolls() - polls, prefix, prefixSize, data, dataSize, NULL, 0);
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Summary
+
+static int compare_bus_time(const void* a, const void* b)
+{
+	uint64_t x = ((const GroveI2CTraceDeviceStats*)a)->BusUs;
+	uint64_t y = ((const GroveI2CTraceDeviceStats*)b)->BusUs;
+	return (x < y) - (x > y);
+}
+
+static int get_devices_locked(GroveI2CTraceDeviceStats* out, int maxDevices)
+{
+	GroveI2CTraceDeviceStats all[TRACE_MAX_DEVICES];
+	for (int i = 0; i < deviceCount; i++)
+	{
+		all[i] = devices[i].Stats;
+		all[i].P50Us = percentile(&devices[i], 500);
+		all[i].P90Us = percentile(&devices[i], 900);
+		all[i].P99Us = percentile(&devices[i], 990);
+	}
+	qsort(all, (size_t)deviceCount, sizeof(all[0]), compare_bus_time);
+
+	int count = deviceCount < maxDevices ? deviceCount : maxDevices;
+	memcpy(out, all, sizeof(all[0]) * (size_t)count);
+	return count;
+}
+
+static void log_summary_locked(uint64_t now)
+{
+	GroveI2CTraceDeviceStats top[TRACE_MAX_DEVICES];
+	int count = get_devices_locked(top, TRACE_MAX_DEVICES);
+
+	uint64_t total = 0;
+	for (int i = 0; i < count; i++) total += top[i].BusUs;
+
+	Log_Debug("I2C top talkers, %u ms traced:\n", (uint32_t)((now - startUs) / 1000));
+	for (int i = 0; i < count; i++)
+	{
+		const GroveI2CTraceDeviceStats* s = &top[i];
+		Log_Debug("  0x%02X %5.1f%% bus %8u tx %10llu B out %8llu B in %8u polls  p50 %u us  p90 %u us  p99 %u us  max %u us\n",
+			s->Address >> 1, total > 0 ? 100.0 * (double)s->BusUs / (double)total : 0.0, s->Transactions,
+			(unsigned long long)s->BytesWritten, (unsigned long long)s->BytesRead, s->StatusPolls,
+			s->P50Us, s->P90Us, s->P99Us, s->MaxUs);
+	}
+
+	lastSummaryUs = now;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GroveI2CTrace
+
+bool GroveI2CTrace_Enable(const char* capturePath)
+{
+	if (enabled) return false;
+
+	devices = (TraceDevice*)malloc(sizeof(TraceDevice) * TRACE_MAX_DEVICES);
+	if (devices == NULL) return false;
+	deviceCount = 0;
+
+	if (capturePath != NULL)
+	{
+		const uint8_t header[8] = { 'G', 'I', '2', 'C', 'T', 'R', 'C', GROVE_I2C_TRACE_VERSION };
+		capture = fopen(capturePath, "wb");
+		if (capture == NULL || fwrite(header, 1, sizeof(header), capture) != sizeof(header))
+		{
+			if (capture != NULL) fclose(capture);
+			capture = NULL;
+			free(devices);
+			devices = NULL;
+			return false;
+		}
+	}
+	captureLost = 0;
+
+	startUs = lastSummaryUs = now_us();
+
+	if (!hooked)
+	{
+		hooked = true;
+		inner_write = GroveI2C_Write;
+		inner_read = GroveI2C_Read;
+		inner_write_read = GroveI2C_WriteRead;
+		inner_write_prefixed = GroveI2C_WritePrefixed;
+		GroveI2C_Write = trace_write;
+		GroveI2C_Read = trace_read;
+		GroveI2C_WriteRead = trace_write_read;
+		GroveI2C_WritePrefixed = trace_write_prefixed;
+	}
+	pthread_mutex_lock(&traceMutex);
+	enabled = true;
+	pthread_mutex_unlock(&traceMutex);
+
+	return true;
+}
+
+void GroveI2CTrace_Disable(void)
+{
+	if (!enabled) return;
+
+	if (GroveI2C_Write == trace_write && GroveI2C_Read == trace_read &&
+		GroveI2C_WriteRead == trace_write_read && GroveI2C_WritePrefixed == trace_write_prefixed)
+	{
+		GroveI2C_Write = inner_write;
+		GroveI2C_Read = inner_read;
+		GroveI2C_WriteRead = inner_write_read;
+		GroveI2C_WritePrefixed = inner_write_prefixed;
+		hooked = false;
+	}
+
+	pthread_mutex_lock(&traceMutex);
+	enabled = false;
+	if (capture != NULL) fclose(capture);
+	capture = NULL;
+	free(devices);
+	devices = NULL;
+	deviceCount = 0;
+	pthread_mutex_unlock(&traceMutex);
+}
+
+void GroveI2CTrace_Reset(void)
+{
+	pthread_mutex_lock(&traceMutex);
+	deviceCount = 0;
+	startUs = lastSummaryUs = now_us();
+	pthread_mutex_unlock(&traceMutex);
+}
+
+void GroveI2CTrace_SetSummaryInterval(uint32_t intervalMs)
+{
+	pthread_mutex_lock(&traceMutex);
+	summaryUs = (uint64_t)intervalMs * 1000;
+	pthread_mutex_unlock(&traceMutex);
+}
+
+void GroveI2CTrace_LogSummary(void)
+{
+	pthread_mutex_lock(&traceMutex);
+	if (enabled) log_summary_locked(now_us());
+	pthread_mutex_unlock(&traceMutex);
+}
+
+uint32_t GroveI2CTrace_GetCaptureLost(void)
+{
+	pthread_mutex_lock(&traceMutex);
+	uint32_t lost = captureLost;
+	pthread_mutex_unlock(&traceMutex);
+
+	return lost;
+}
+
+int GroveI2CTrace_GetDevices(GroveI2CTraceDeviceStats* out, int maxDevices)
+{
+	pthread_mutex_lock(&traceMutex);
+	int count = enabled ? get_devices_locked(out, maxDevices) : 0;
+	pthread_mutex_unlock(&traceMutex);
+
+	return count;
+}
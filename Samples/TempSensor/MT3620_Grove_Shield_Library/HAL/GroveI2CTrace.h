@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../applibs_versions.h"
+
+// Transaction tracer: wraps the GroveI2C_Write/Read/WriteRead/WritePrefixed pointers and accounts every call to its device.
+// Enable it after selecting the backend; a bus arbiter opened afterwards runs the tracer under its lock, and disabling
+// the tracer first leaves that arbiter hooked.
+//
+// Capture file: the 8 byte header "GI2CTRC" + version, then one record per transaction, little endian:
+//   u32 start (us since enable), u32 latency (us), u8 address (8-bit), u8 op, u8 ok, u8 status polls,
+//   u16 write size, u16 read size, then the write payload followed by the read payload.
+// SC18IM700Emulator/TraceDump.c decodes it.
+
+#define GROVE_I2C_TRACE_VERSION		1
+
+typedef enum
+{
+	GroveI2CTrace_Op_Write = 'W',
+	GroveI2CTrace_Op_Read = 'R',
+	GroveI2CTrace_Op_WriteRead = 'X'
+}
+GroveI2CTrace_Op;
+
+typedef struct
+{
+	uint8_t Address;			// 8-bit, R/W bit clear
+	uint32_t Transactions;
+	uint32_t Failures;
+	uint64_t BytesWritten;
+	uint64_t BytesRead;
+	uint32_t StatusPolls;		// bridge I2CStat reads spent on this device's writes
+	uint64_t BusUs;				// total time inside the backend
+	uint32_t P50Us;				// latency percentiles, bucketed to within 25 %
+	uint32_t P90Us;
+	uint32_t P99Us;
+	uint32_t MaxUs;
+}
+GroveI2CTraceDeviceStats;
+
+// capturePath may be NULL to collect statistics only.
+bool GroveI2CTrace_Enable(const char* capturePath);
+void GroveI2CTrace_Disable(void);
+void GroveI2CTrace_Reset(void);
+
+// Logs the top talkers every intervalMs from inside traced calls; 0 turns the periodic summary off.
+void GroveI2CTrace_SetSummaryInterval(uint32_t intervalMs);
+void GroveI2CTrace_LogSummary(void);
+
+// Fills up to maxDevices entries ordered by bus time, busiest first; returns the number filled.
+int GroveI2CTrace_GetDevices(GroveI2CTraceDeviceStats* devices, int maxDevices);
+
+// Transactions missing from the capture file: a failed write closes the file, leaving its last record torn, and
+// every later transaction is counted here while the statistics keep being collected.
+uint32_t GroveI2CTrace_GetCaptureLost(void);
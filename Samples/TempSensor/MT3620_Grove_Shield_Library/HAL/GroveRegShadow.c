@@ -0,0 +1,124 @@
+#include "GroveRegShadow.h"
+#include <stdlib.h>
+#include <string.h>
+#include "GroveI2C.h"
+
+typedef struct GroveRegShadowInstance
+{
+	struct GroveRegShadowInstance* Next;
+	int RefCount;
+	int I2cFd;
+	uint8_t Address;
+	int RegCount;
+	uint8_t* Values;
+	uint8_t* Valid;
+	GroveRegShadowStats Stats;
+}
+GroveRegShadowInstance;
+
+// Every driver instance talking to the same device shares one shadow
+static GroveRegShadowInstance* shadows;
+
+void* GroveRegShadow_Open(int i2cFd, uint8_t address, int regCount)
+{
+	for (GroveRegShadowInstance* it = shadows; it != NULL; it = it->Next)
+	{
+		if (it->I2cFd == i2cFd && it->Address == address && it->RegCount == regCount)
+		{
+			it->RefCount++;
+			return it;
+		}
+	}
+
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)malloc(sizeof(GroveRegShadowInstance) + 2 * (size_t)regCount);
+	if (this == NULL) return NULL;
+
+	this->Next = shadows;
+	shadows = this;
+	this->RefCount = 1;
+	this->I2cFd = i2cFd;
+	this->Address = address;
+	this->RegCount = regCount;
+	this->Values = (uint8_t*)(this + 1);
+	this->Valid = this->Values + regCount;
+	memset(&this->Stats, 0, sizeof(this->Stats));
+	GroveRegShadow_Invalidate(this);
+
+	return this;
+}
+
+void GroveRegShadow_Close(void* inst)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+	if (this == NULL || --this->RefCount > 0) return;
+
+	for (GroveRegShadowInstance** it = &shadows; *it != NULL; it = &(*it)->Next)
+	{
+		if (*it == this)
+		{
+			*it = this->Next;
+			break;
+		}
+	}
+	free(this);
+}
+
+bool GroveRegShadow_WriteReg8(void* inst, uint8_t reg, uint8_t val)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+
+	bool cached = reg < this->RegCount;
+	if (cached && this->Valid[reg] && this->Values[reg] == val)
+	{
+		this->Stats.Suppressed++;
+		return true;
+	}
+
+	// Cached only once the device acknowledged it; a failed write leaves the register unknown so the next one retries
+	this->Stats.Writes++;
+	if (!GroveI2C_WriteReg8(this->I2cFd, this->Address, reg, val))
+	{
+		this->Stats.Failures++;
+		if (cached) this->Valid[reg] = 0;
+		return false;
+	}
+
+	if (cached)
+	{
+		this->Values[reg] = val;
+		this->Valid[reg] = 1;
+	}
+
+	return true;
+}
+
+bool GroveRegShadow_Get(void* inst, uint8_t reg, uint8_t* val)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+
+	if (reg >= this->RegCount || !this->Valid[reg]) return false;
+
+	*val = this->Values[reg];
+	return true;
+}
+
+void GroveRegShadow_Invalidate(void* inst)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+
+	memset(this->Valid, 0, (size_t)this->RegCount);
+}
+
+void GroveRegShadow_InvalidateReg(void* inst, uint8_t reg)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+
+	if (reg < this->RegCount) this->Valid[reg] = 0;
+}
+
+void GroveRegShadow_GetStats(void* inst, GroveRegShadowStats* stats)
+{
+	GroveRegShadowInstance* this = (GroveRegShadowInstance*)inst;
+
+	*stats = this->Stats;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../applibs_versions.h"
+
+// Write-through register shadow for one I2C device.
+// Writes that match the cached value are dropped; registers start out unknown and are always written the first time.
+// Opening the same fd/address again returns the same shadow (reference counted), so drivers sharing a device agree.
+// Invalidate after anything that changes device registers behind the shadow's back (reset, power cycle, raw writes).
+
+typedef struct
+{
+	uint32_t Writes;		// register writes sent to the device
+	uint32_t Suppressed;	// register writes dropped because the value was already there
+	uint32_t Failures;		// register writes the device did not acknowledge
+}
+GroveRegShadowStats;
+
+void* GroveRegShadow_Open(int i2cFd, uint8_t address, int regCount);
+void GroveRegShadow_Close(void* inst);
+
+// Returns true once the register holds val, whether it was written or the write was suppressed (see Stats), and
+// false if the bus write failed.
+bool GroveRegShadow_WriteReg8(void* inst, uint8_t reg, uint8_t val);
+
+// Cached value, false if the register has not been written since the last invalidation.
+bool GroveRegShadow_Get(void* inst, uint8_t reg, uint8_t* val);
+
+void GroveRegShadow_Invalidate(void* inst);
+void GroveRegShadow_InvalidateReg(void* inst, uint8_t reg);
+
+void GroveRegShadow_GetStats(void* inst, GroveRegShadowStats* stats);
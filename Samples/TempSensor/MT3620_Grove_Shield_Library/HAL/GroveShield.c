@@ -12,69 +12,256 @@
 
 /**
 	Set bauud rate for SC18IM700
+	baud = 7372800 / (16 + BRG), BRG = BRG1:BRG0. BRG 0 gives the 460800 maximum.
 */
-const uint8_t baudrate_230400_conf[4] = { 0x00, 0x10, 0x01, 0x00 };
-const uint8_t baudrate_115200_conf[4] = { 0x00, 0x30, 0x01, 0x00};
-const uint8_t baudrate_19200_conf[4] = { 0x00, 0x70, 0x01, 0x01};
-const uint8_t baudrate_14400_conf[4] = { 0x00, 0xF4, 0x01, 0x01};
-const uint8_t baudrate_9600_conf[4] = { 0x00, 0xF0, 0x01, 0x02};
+#define SC18IM700_CLOCK_HZ		7372800
+#define SC18IM700_MAX_BAUDRATE	(SC18IM700_CLOCK_HZ / 16)
+#define SC18IM700_REG_BRG0		0x00
+#define SC18IM700_REG_BRG1		0x01
+#define SC18IM700_REG_I2CADR	0x06
 
-static void baudrate_conf(int *fd, UART_BaudRate_Type baudrate)
+#define BAUDRATE_TOLERANCE		50		// 2 %, in 1/1000
+
+// Probed after the requested rate: 9600 is the power-on rate, the rest are what an earlier run may have left behind.
+static const uint32_t probe_baudrates[] = { 9600, 115200, 230400, 460800, 368640, 307200, 153600, 57600, 38400, 19200, 14400 };
+
+// Link tuning ladder; each rate is an exact BRG divisor.
+static const uint32_t tune_baudrates[] = { 115200, 153600, 230400, 307200, 368640, 460800 };
+
+#define PROBE_TIMEOUT_MS		50
+#define TUNE_CHECK_ROUNDS		8
+#define TUNE_BURST_SIZE			64
+#define TUNE_BACKOFF_ATTEMPTS	3
+
+// Builds the 'W' payload for baudrate; fails when no divisor gets within BAUDRATE_TOLERANCE.
+static bool baudrate_conf(uint32_t baudrate, uint8_t conf[4])
+{
+	if (baudrate == 0 || baudrate > SC18IM700_MAX_BAUDRATE) return false;
+
+	uint32_t divisor = (SC18IM700_CLOCK_HZ + baudrate / 2) / baudrate;
+	if (divisor < 16 || divisor - 16 > 0xFFFF) return false;
+
+	uint32_t actual = SC18IM700_CLOCK_HZ / divisor;
+	uint32_t error = actual > baudrate ? actual - baudrate : baudrate - actual;
+	if (error * 1000 > baudrate * BAUDRATE_TOLERANCE) return false;
+
+	uint32_t brg = divisor - 16;
+	conf[0] = SC18IM700_REG_BRG0;
+	conf[1] = (uint8_t)(brg & 0xFF);
+	conf[2] = SC18IM700_REG_BRG1;
+	conf[3] = (uint8_t)(brg >> 8);
+
+	return true;
+}
+
+static uint32_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void close_link(int* fd)
+{
+	if (*fd >= 0) GroveUART_Close(*fd);
+	*fd = -1;
+}
+
+// Opens the UART at baudrate and checks that the bridge answers with the matching BRG registers.
+static bool probe(int* fd, uint32_t baudrate, const uint8_t* conf)
 {
-	static uint8_t trial = 0;
-	uint8_t d0, d1;
-	uint8_t conf[4] = { 0 };
+	if (*fd >= 0) GroveUART_Close(*fd);
+	*fd = GroveUART_Open(MT3620_RDB_HEADER2_ISU0_UART, baudrate);
+	if (*fd < 0) return false;
+
+	GroveUART_DiscardInput(*fd);
+	GroveUART_SetReadTimeout(*fd, PROBE_TIMEOUT_MS);
+
+	// The leading 'P' terminates whatever half command line noise may have left the bridge in
+	const uint8_t send[5] = { 'P', 'R', 0x00, 0x01, 'P' };
+	uint8_t brg[2] = { 0 };
+	bool ok = GroveUART_Write(*fd, send, sizeof(send)) && GroveUART_Read(*fd, brg, sizeof(brg));
 
-	close(*fd);
-	*fd = GroveUART_Open(MT3620_RDB_HEADER2_ISU0_UART, 9600);
+	GroveUART_SetReadTimeout(*fd, GROVE_UART_DEFAULT_TIMEOUT_MS);
 
-	while (true)
+	return ok && brg[0] == conf[1] && brg[1] == conf[3];
+}
+
+// Reprograms the bridge from currentBaudrate to baudrate, reopens the UART and verifies the switch once.
+static bool switch_baudrate(int* fd, uint32_t currentBaudrate, uint32_t baudrate, const uint8_t conf[4])
+{
+	/** Change UART baudrate for SC18IM700 */
+	if (!SC18IM700_WriteRegBytes(*fd, (uint8_t*)conf, 4)) return false;
+	GroveUART_Flush(*fd);
+
+	// Let the 6 byte command leave the wire before the UART is reopened at the new rate
+	usleep((long)(6 * 10 * 1000000 / currentBaudrate) + 1000);
+
+	return probe(fd, baudrate, conf);
+}
+
+// Pattern write/read-back plus a register burst; returns false on any mismatch, otherwise the link's bytes per second.
+static bool check_link(int fd, uint32_t* bytesPerSecond)
+{
+	GroveUARTStats before, after;
+	GroveUART_GetStats(fd, &before);
+	uint32_t start = now_ms();
+
+	for (int round = 0; round < TUNE_CHECK_ROUNDS; round++)
 	{
-		d0 = 0, d1 = 0;
-		while (d0 != baudrate_9600_conf[1])
+		static const uint8_t patterns[] = { 0x55, 0xAA, 0x00, 0xFF };
+		uint8_t pattern = (uint8_t)(patterns[round % 4] ^ round);
+		uint8_t value;
+
+		SC18IM700_WriteReg(fd, SC18IM700_REG_I2CADR, pattern);
+		if (!SC18IM700_ReadReg(fd, SC18IM700_REG_I2CADR, &value) || value != pattern) return false;
+
+		// One long 'R' command streams TUNE_BURST_SIZE copies of the register back
+		uint8_t send[TUNE_BURST_SIZE + 2];
+		uint8_t recv[TUNE_BURST_SIZE];
+		send[0] = 'R';
+		memset(&send[1], SC18IM700_REG_I2CADR, TUNE_BURST_SIZE);
+		send[TUNE_BURST_SIZE + 1] = 'P';
+		if (!GroveUART_Write(fd, send, sizeof(send)) || !GroveUART_Read(fd, recv, sizeof(recv))) return false;
+		for (int i = 0; i < TUNE_BURST_SIZE; i++)
 		{
-			SC18IM700_ReadReg(*fd, 0x00, &d0);			
+			if (recv[i] != pattern) return false;
 		}
-		while (d1 != baudrate_9600_conf[3])
-		{
-			SC18IM700_ReadReg(*fd, 0x01, &d1);
-		}		
-		//Log_Debug("BR1: %x %x\n", d0, d1);
-		if (d0 == baudrate_9600_conf[1] && d1 == baudrate_9600_conf[3]) break;
-		usleep(500000);
 	}
 
-	/** Change UART baudrate for SC18IM700 */		
-	if (baudrate == 230400) memcpy(conf, baudrate_230400_conf, 4);
-	else if(baudrate == 115200) memcpy(conf, baudrate_115200_conf, 4);
-	else if (baudrate == 19200) memcpy(conf, baudrate_19200_conf, 4);
-	else if (baudrate == 14400) memcpy(conf, baudrate_14400_conf, 4);
-	else if (baudrate == 9600) memcpy(conf, baudrate_9600_conf, 4);
-	else {
-		Log_Debug("[error] Baudrate not found.");
-		return;
-	}
-	SC18IM700_WriteRegBytes(*fd, conf, 4);
+	uint32_t elapsed = now_ms() - start;
+	GroveUART_GetStats(fd, &after);
+	uint64_t bytes = (after.TxBytes - before.TxBytes) + (after.RxBytes - before.RxBytes);
+	*bytesPerSecond = (uint32_t)(bytes * 1000 / (elapsed > 0 ? elapsed : 1));
 
-	close(*fd);
-	*fd = GroveUART_Open(MT3620_RDB_HEADER2_ISU0_UART, baudrate);
+	return true;
+}
+
+bool GroveShield_InitializeEx(int* fd, uint32_t baudrate, GroveShieldInitInfo* info)
+{
+	uint32_t start = now_ms();
+	GroveShieldInitInfo result = { 0 };
+
+	uint8_t conf[4];
+	if (!baudrate_conf(baudrate, conf))
+	{
+		Log_Debug("[error] Baudrate not found.\n");
+		close_link(fd);
+		return false;
+	}
 
-	SC18IM700_ReadReg(*fd, 0x00, &d0);
-	SC18IM700_ReadReg(*fd, 0x01, &d1);
+	// Detect the rate the bridge currently runs at; a warm restart usually finds it at the requested one.
+	// Probing closes a link left open by an earlier call before reopening the UART.
+	result.Probes++;
+	if (probe(fd, baudrate, conf))
+	{
+		result.DetectedBaudRate = baudrate;
+	}
+	else
+	{
+		for (size_t i = 0; i < sizeof(probe_baudrates) / sizeof(probe_baudrates[0]) && result.DetectedBaudRate == 0; i++)
+		{
+			uint8_t probeConf[4];
+			if (probe_baudrates[i] == baudrate || !baudrate_conf(probe_baudrates[i], probeConf)) continue;
 
-	//Log_Debug("BR2: %x %x\n", d0, d1);
+			result.Probes++;
+			if (probe(fd, probe_baudrates[i], probeConf)) result.DetectedBaudRate = probe_baudrates[i];
+		}
+	}
 
-	if ((d0 != conf[1]) || (d1 != conf[3]))
+	if (result.DetectedBaudRate == 0)
+	{
+		Log_Debug("[error] Grove shield not responding.\n");
+	}
+	else if (result.DetectedBaudRate == baudrate)
+	{
+		result.BaudRate = baudrate;
+	}
+	else
 	{
-		trial++;
-		if (trial > 10) return;
-		baudrate_conf(fd, baudrate);
+		result.Probes++;
+		if (switch_baudrate(fd, result.DetectedBaudRate, baudrate, conf)) result.BaudRate = baudrate;
+		else Log_Debug("[error] Grove shield did not switch to %u baud.\n", baudrate);
 	}
-	trial = 0;
+
+	result.ElapsedMs = now_ms() - start;
+	Log_Debug("Grove shield: found at %u baud, running at %u baud, %u probes, %u ms\n",
+		result.DetectedBaudRate, result.BaudRate, result.Probes, result.ElapsedMs);
+
+	// A failed bring-up leaves no half-configured port behind
+	if (result.BaudRate == 0) close_link(fd);
+
+	if (info != NULL) *info = result;
+	return result.BaudRate != 0;
 }
 
 void GroveShield_Initialize(int* fd, uint32_t baudrate)
 {
-	/**fd = GroveUART_Open(MT3620_RDB_HEADER2_ISU0_UART, 9600);*/
-	baudrate_conf(fd, baudrate);
-}
\ No newline at end of file
+	GroveShield_InitializeEx(fd, baudrate, NULL);
+}
+
+bool GroveShield_TuneLink(int* fd, uint32_t maxBaudrate, GroveShieldLinkInfo* info)
+{
+	uint32_t start = now_ms();
+	GroveShieldLinkInfo result = { 0 };
+
+	// Tuning only steps up from 115200, so a lower cap cannot be met
+	if (maxBaudrate < tune_baudrates[0])
+	{
+		Log_Debug("[error] Grove shield link cannot be tuned below %u baud.\n", tune_baudrates[0]);
+		return false;
+	}
+
+	// Start from whatever the bridge runs at now; bring it to 115200 first if it is not answering there
+	GroveShieldInitInfo initInfo;
+	if (!GroveShield_InitializeEx(fd, tune_baudrates[0], &initInfo)) return false;
+
+	uint32_t goodBaudrate = tune_baudrates[0];
+	if (!check_link(*fd, &result.BytesPerSecond))
+	{
+		Log_Debug("[error] Grove shield link fails checks at %u baud.\n", goodBaudrate);
+		close_link(fd);
+		return false;
+	}
+
+	for (size_t i = 1; i < sizeof(tune_baudrates) / sizeof(tune_baudrates[0]); i++)
+	{
+		uint32_t baudrate = tune_baudrates[i];
+		if (baudrate > maxBaudrate) break;
+
+		uint8_t conf[4];
+		uint32_t bytesPerSecond;
+		if (!baudrate_conf(baudrate, conf)) continue;
+
+		result.Steps++;
+		if (switch_baudrate(fd, goodBaudrate, baudrate, conf) && check_link(*fd, &bytesPerSecond))
+		{
+			goodBaudrate = baudrate;
+			result.BytesPerSecond = bytesPerSecond;
+			continue;
+		}
+
+		// Back off to the last rate that passed; detection copes with the bridge being on either side of the failed switch,
+		// and the switch command itself may be mangled on the bad link, so give it a few goes
+		Log_Debug("Grove shield: %u baud failed link checks, backing off to %u baud\n", baudrate, goodBaudrate);
+		bool recovered = false;
+		for (int attempt = 0; attempt < TUNE_BACKOFF_ATTEMPTS && !recovered; attempt++)
+		{
+			recovered = GroveShield_InitializeEx(fd, goodBaudrate, &initInfo) && check_link(*fd, &result.BytesPerSecond);
+		}
+		if (!recovered)
+		{
+			close_link(fd);
+			return false;
+		}
+		break;
+	}
+
+	result.BaudRate = goodBaudrate;
+	result.ElapsedMs = now_ms() - start;
+	Log_Debug("Grove shield: link tuned to %u baud, %u bytes/s, %u steps, %u ms\n",
+		result.BaudRate, result.BytesPerSecond, result.Steps, result.ElapsedMs);
+
+	if (info != NULL) *info = result;
+	return true;
+}
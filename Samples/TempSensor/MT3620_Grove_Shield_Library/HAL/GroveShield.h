@@ -1,8 +1,34 @@
 #pragma once
 #include <time.h>
+#include <stdbool.h>
 
 #include "../applibs_versions.h"
 #include "stdint.h"
 
+typedef struct
+{
+	uint32_t DetectedBaudRate;	// rate the bridge answered at before switching, 0 if it never answered
+	uint32_t BaudRate;			// rate the link runs at now, 0 on failure
+	uint32_t Probes;			// register read-backs issued, including the final verification
+	uint32_t ElapsedMs;
+}
+GroveShieldInitInfo;
 
-void GroveShield_Initialize(int* i2cFd, uint32_t baudrate);
\ No newline at end of file
+// Opens the shield UART into *fd, detects the bridge's current baud rate, switches it to baudrate and verifies it once.
+// *fd must be -1 or a link from an earlier call, which is closed first. On failure *fd is closed and set to -1.
+bool GroveShield_InitializeEx(int* i2cFd, uint32_t baudrate, GroveShieldInitInfo* info);
+void GroveShield_Initialize(int* i2cFd, uint32_t baudrate);
+
+typedef struct
+{
+	uint32_t BaudRate;			// fastest rate that passed the link checks
+	uint32_t BytesPerSecond;	// UART bytes moved per second during the checks at BaudRate
+	uint32_t Steps;				// rate increases attempted
+	uint32_t ElapsedMs;
+}
+GroveShieldLinkInfo;
+
+// Steps the bridge up from 115200 towards maxBaudrate (at most 460800) until pattern checks fail, then backs off
+// to the fastest rate that passed. *fd must come from GroveShield_Initialize or be -1; on failure it is closed and -1.
+// A maxBaudrate below 115200 is rejected up front and leaves *fd as it was; use GroveShield_Initialize for slower links.
+bool GroveShield_TuneLink(int* i2cFd, uint32_t maxBaudrate, GroveShieldLinkInfo* info);
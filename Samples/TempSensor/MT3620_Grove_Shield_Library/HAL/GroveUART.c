@@ -2,32 +2,382 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/uio.h>
 
 #include <applibs/uart.h>
 
+// Ring sizes must be powers of two; head/tail are free-running indices.
+#define GROVE_UART_MAX_PORTS	4
+#define GROVE_UART_TX_SIZE		1024
+#define GROVE_UART_RX_SIZE		512
+
+typedef struct
+{
+	bool InUse;
+	int Fd;
+	int TimeoutMs;
+	bool RxStale;			// a Read timed out; the rest of its reply may still arrive
+	uint32_t TxHead;
+	uint32_t TxTail;
+	uint32_t RxHead;
+	uint32_t RxTail;
+	GroveUARTStats Stats;
+	uint8_t TxBuffer[GROVE_UART_TX_SIZE];
+	uint8_t RxBuffer[GROVE_UART_RX_SIZE];
+}
+GroveUARTPort;
+
+static GroveUARTPort ports[GROVE_UART_MAX_PORTS];
+
+////////////////////////////////////////////////////////////////////////////////
+// Port table
+
+static GroveUARTPort* find_port(int fd)
+{
+	for (int i = 0; i < GROVE_UART_MAX_PORTS; i++)
+	{
+		if (ports[i].InUse && ports[i].Fd == fd) return &ports[i];
+	}
+	return NULL;
+}
+
+static GroveUARTPort* attach_port(int fd)
+{
+	if (fd < 0) return NULL;
+
+	GroveUARTPort* port = find_port(fd);
+	if (port != NULL) return port;
+
+	for (int i = 0; i < GROVE_UART_MAX_PORTS; i++)
+	{
+		if (!ports[i].InUse)
+		{
+			port = &ports[i];
+			port->InUse = true;
+			port->Fd = fd;
+			port->TimeoutMs = GROVE_UART_DEFAULT_TIMEOUT_MS;
+			port->TxHead = port->TxTail = 0;
+			port->RxHead = port->RxTail = 0;
+			port->RxStale = false;
+			memset(&port->Stats, 0, sizeof(port->Stats));
+
+			// All transfers are driven by poll(), so the fd must never block
+			int flags = fcntl(fd, F_GETFL);
+			if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+			return port;
+		}
+	}
+	return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Returns 1 when the fd is ready, 0 on timeout, -1 on error.
+static int wait_fd(GroveUARTPort* port, short events, int64_t deadline)
+{
+	for (;;)
+	{
+		int64_t remaining = deadline - now_ms();
+		if (remaining < 0) remaining = 0;
+
+		struct pollfd pfd = { .fd = port->Fd, .events = events, .revents = 0 };
+		port->Stats.PollCalls++;
+		int result = poll(&pfd, 1, (int)remaining);
+		if (result > 0) return (pfd.revents & (POLLERR | POLLNVAL)) ? -1 : 1;
+		if (result == 0)
+		{
+			port->Stats.Timeouts++;
+			return 0;
+		}
+		if (errno != EINTR) return -1;
+	}
+}
+
+// Fills iov with the (at most two) contiguous spans of [start, start + count) in a ring.
+static int ring_spans(uint8_t* buffer, uint32_t size, uint32_t start, uint32_t count, struct iovec iov[2])
+{
+	uint32_t offset = start & (size - 1);
+	uint32_t first = size - offset;
+	if (first > count) first = count;
+
+	iov[0].iov_base = &buffer[offset];
+	iov[0].iov_len = first;
+	if (first == count) return 1;
+
+	iov[1].iov_base = buffer;
+	iov[1].iov_len = count - first;
+	return 2;
+}
+
+// Pulls everything the driver has buffered into the RX ring. Returns bytes read, 0 if none, -1 on error.
+static int fill_rx(GroveUARTPort* port)
+{
+	uint32_t space = GROVE_UART_RX_SIZE - (port->RxHead - port->RxTail);
+	if (space == 0) return 0;
+
+	struct iovec iov[2];
+	int iovcnt = ring_spans(port->RxBuffer, GROVE_UART_RX_SIZE, port->RxHead, space, iov);
+
+	for (;;)
+	{
+		port->Stats.ReadCalls++;
+		ssize_t readSize = readv(port->Fd, iov, iovcnt);
+		if (readSize > 0)
+		{
+			port->RxHead += (uint32_t)readSize;
+			port->Stats.RxBytes += (uint64_t)readSize;
+			return (int)readSize;
+		}
+		if (readSize < 0 && errno == EINTR) continue;
+		if (readSize < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+		return -1;
+	}
+}
+
+// Drops the RX ring and whatever the driver has buffered
+static void discard_rx(GroveUARTPort* port)
+{
+	do
+	{
+		port->RxTail = port->RxHead;
+	} while (fill_rx(port) > 0);
+	port->RxTail = port->RxHead;
+}
+
+// After a timed-out Read, late reply bytes are dropped before the next request goes out so they can't be taken
+// for its reply
+static void drop_stale_rx(GroveUARTPort* port)
+{
+	if (!port->RxStale) return;
+
+	port->RxStale = false;
+	discard_rx(port);
+}
+
+static bool flush_tx(GroveUARTPort* port)
+{
+	if (port->TxHead != port->TxTail) drop_stale_rx(port);
+
+	int64_t deadline = now_ms() + port->TimeoutMs;
+
+	while (port->TxHead != port->TxTail)
+	{
+		struct iovec iov[2];
+		int iovcnt = ring_spans(port->TxBuffer, GROVE_UART_TX_SIZE, port->TxTail, port->TxHead - port->TxTail, iov);
+
+		port->Stats.WriteCalls++;
+		ssize_t written = writev(port->Fd, iov, iovcnt);
+		if (written > 0)
+		{
+			port->TxTail += (uint32_t)written;
+			port->Stats.TxBytes += (uint64_t)written;
+			continue;
+		}
+		if (written < 0 && errno == EINTR) continue;
+		if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+		if (wait_fd(port, POLLOUT, deadline) <= 0) return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GroveUART
+
 int GroveUART_Open(UART_Id id, UART_BaudRate_Type baudRate)
 {
 	UART_Config uartConfig;
 	UART_InitConfig(&uartConfig);
 	uartConfig.baudRate = baudRate;
 
-	return UART_Open(id, &uartConfig);
+	int fd = UART_Open(id, &uartConfig);
+	attach_port(fd);
+
+	return fd;
+}
+
+void GroveUART_Close(int fd)
+{
+	GroveUARTPort* port = find_port(fd);
+	if (port != NULL)
+	{
+		flush_tx(port);
+		port->InUse = false;
+	}
+	if (fd >= 0) close(fd);
+}
+
+bool GroveUART_Queue(int fd, const uint8_t* data, int dataSize)
+{
+	GroveUARTPort* port = attach_port(fd);
+	if (port == NULL) return false;
+
+	while (dataSize > 0)
+	{
+		uint32_t space = GROVE_UART_TX_SIZE - (port->TxHead - port->TxTail);
+		if (space == 0)
+		{
+			if (!flush_tx(port)) return false;
+			continue;
+		}
+
+		uint32_t count = (uint32_t)dataSize < space ? (uint32_t)dataSize : space;
+		struct iovec iov[2];
+		int iovcnt = ring_spans(port->TxBuffer, GROVE_UART_TX_SIZE, port->TxHead, count, iov);
+		for (int i = 0; i < iovcnt; i++)
+		{
+			memcpy(iov[i].iov_base, data, iov[i].iov_len);
+			data += iov[i].iov_len;
+		}
+		port->TxHead += count;
+		dataSize -= (int)count;
+	}
+	return true;
 }
 
-void GroveUART_Write(int fd, const uint8_t* data, int dataSize)
-{	
-	write(fd, data, (size_t)dataSize);
+bool GroveUART_Flush(int fd)
+{
+	GroveUARTPort* port = attach_port(fd);
+	if (port == NULL) return false;
+
+	return flush_tx(port);
+}
+
+bool GroveUART_Write(int fd, const uint8_t* data, int dataSize)
+{
+	if (!GroveUART_Queue(fd, data, dataSize)) return false;
+
+	return GroveUART_Flush(fd);
+}
+
+bool GroveUART_WriteV(int fd, const struct iovec* iov, int iovcnt)
+{
+	GroveUARTPort* port = attach_port(fd);
+	if (port == NULL || iovcnt > GROVE_UART_MAX_IOV) return false;
+
+	// Queued bytes go first so ordering holds; empty iovecs are dropped
+	struct iovec vec[2 + GROVE_UART_MAX_IOV];
+	uint32_t queued = port->TxHead - port->TxTail;
+	int count = queued > 0 ? ring_spans(port->TxBuffer, GROVE_UART_TX_SIZE, port->TxTail, queued, vec) : 0;
+	for (int i = 0; i < iovcnt; i++)
+	{
+		if (iov[i].iov_len > 0) vec[count++] = iov[i];
+	}
+	if (count > 0) drop_stale_rx(port);
+
+	int64_t deadline = now_ms() + port->TimeoutMs;
+	int first = 0;
+	while (first < count)
+	{
+		port->Stats.WriteCalls++;
+		ssize_t written = writev(port->Fd, &vec[first], count - first);
+		if (written > 0)
+		{
+			port->Stats.TxBytes += (uint64_t)written;
+
+			uint32_t fromRing = (uint32_t)written < queued ? (uint32_t)written : queued;
+			port->TxTail += fromRing;
+			queued -= fromRing;
+
+			size_t remaining = (size_t)written;
+			while (remaining > 0 && remaining >= vec[first].iov_len)
+			{
+				remaining -= vec[first].iov_len;
+				first++;
+			}
+			if (remaining > 0)
+			{
+				vec[first].iov_base = (uint8_t*)vec[first].iov_base + remaining;
+				vec[first].iov_len -= remaining;
+			}
+			continue;
+		}
+		if (written < 0 && errno == EINTR) continue;
+		if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+		if (wait_fd(port, POLLOUT, deadline) <= 0) return false;
+	}
+	return true;
 }
 
 bool GroveUART_Read(int fd, uint8_t* data, int dataSize)
 {
+	GroveUARTPort* port = attach_port(fd);
+	if (port == NULL) return false;
+
+	port->Stats.Requests++;
+
+	// The request may still sit in the TX ring
+	if (!flush_tx(port)) return false;
+
+	int64_t deadline = now_ms() + port->TimeoutMs;
 	int totalReadSize = 0;
-	do
+	while (totalReadSize < dataSize)
 	{
-		int readSize = read(fd, &data[totalReadSize], (size_t)(dataSize - totalReadSize));
-		if (readSize < 0) return false;
-		totalReadSize += readSize;
-	} while (totalReadSize < dataSize);
+		uint32_t available = port->RxHead - port->RxTail;
+		if (available == 0)
+		{
+			int readSize = fill_rx(port);
+			if (readSize < 0) return false;
+			if (readSize == 0 && wait_fd(port, POLLIN, deadline) <= 0)
+			{
+				// Whatever part of the reply arrived is useless now, and the rest may follow later
+				discard_rx(port);
+				port->RxStale = true;
+				return false;
+			}
+			continue;
+		}
+
+		uint32_t count = available < (uint32_t)(dataSize - totalReadSize) ? available : (uint32_t)(dataSize - totalReadSize);
+		struct iovec iov[2];
+		int iovcnt = ring_spans(port->RxBuffer, GROVE_UART_RX_SIZE, port->RxTail, count, iov);
+		for (int i = 0; i < iovcnt; i++)
+		{
+			memcpy(&data[totalReadSize], iov[i].iov_base, iov[i].iov_len);
+			totalReadSize += (int)iov[i].iov_len;
+		}
+		port->RxTail += count;
+	}
 
 	return true;
 }
+
+void GroveUART_DiscardInput(int fd)
+{
+	GroveUARTPort* port = attach_port(fd);
+	if (port == NULL) return;
+
+	discard_rx(port);
+}
+
+void GroveUART_SetReadTimeout(int fd, int timeoutMs)
+{
+	GroveUARTPort* port = attach_port(fd);
+	if (port != NULL) port->TimeoutMs = timeoutMs;
+}
+
+void GroveUART_GetStats(int fd, GroveUARTStats* stats)
+{
+	GroveUARTPort* port = find_port(fd);
+	if (port != NULL) *stats = port->Stats;
+	else memset(stats, 0, sizeof(*stats));
+}
+
+void GroveUART_ResetStats(int fd)
+{
+	GroveUARTPort* port = find_port(fd);
+	if (port != NULL) memset(&port->Stats, 0, sizeof(port->Stats));
+}
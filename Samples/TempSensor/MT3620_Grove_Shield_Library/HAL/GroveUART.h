@@ -1,11 +1,43 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/uio.h>
 
 #include "../applibs_versions.h"
 #include <applibs/uart.h>
 
+#define GROVE_UART_DEFAULT_TIMEOUT_MS	1000
+#define GROVE_UART_MAX_IOV				8
+
+typedef struct
+{
+	uint64_t TxBytes;
+	uint64_t RxBytes;
+	uint32_t Requests;		// GroveUART_Read calls, i.e. bridge round trips
+	uint32_t WriteCalls;	// writev() syscalls
+	uint32_t ReadCalls;		// readv() syscalls
+	uint32_t PollCalls;		// poll() syscalls spent waiting on the fd
+	uint32_t Timeouts;
+}
+GroveUARTStats;
 
 int GroveUART_Open(UART_Id id, uint32_t baudRate);
-void GroveUART_Write(int fd, const uint8_t* data, int dataSize);
+void GroveUART_Close(int fd);
+
+// Write queues the data and flushes it; Queue only flushes when the TX ring is full.
+bool GroveUART_Write(int fd, const uint8_t* data, int dataSize);
+bool GroveUART_Queue(int fd, const uint8_t* data, int dataSize);
+bool GroveUART_Flush(int fd);
+
+// Sends anything queued followed by the iovecs straight from the caller's buffers, in one writev() where the
+// driver takes it all. Returns once everything is written; at most GROVE_UART_MAX_IOV iovecs.
+bool GroveUART_WriteV(int fd, const struct iovec* iov, int iovcnt);
+
+// Read flushes pending TX data first, then blocks until dataSize bytes arrived or the timeout elapsed. On timeout the
+// partial reply is dropped, and bytes still trickling in for it are dropped before the next request is sent.
 bool GroveUART_Read(int fd, uint8_t* data, int dataSize);
+void GroveUART_DiscardInput(int fd);
+void GroveUART_SetReadTimeout(int fd, int timeoutMs);
+
+void GroveUART_GetStats(int fd, GroveUARTStats* stats);
+void GroveUART_ResetStats(int fd);
@@ -1,65 +1,391 @@
 #include "GroveAD7992.h"
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "../HAL/GroveI2C.h"
+#include "../HAL/GroveI2CBus.h"
+#include "../HAL/GroveRegShadow.h"
 
 #include <applibs/gpio.h>
 
 #define AD7992_ADDRESS					(0x20 << 1)
 
 #define AD7992_REG_CONVERSION_RESULT	(0x0)
+#define AD7992_REG_ALERT_STATUS			(0x1)
 #define AD7992_REG_CONFIGURATION		(0x2)
+#define AD7992_REG_CYCLE_TIMER			(0x3)
+#define AD7992_REG_DATA_LOW(ch)			(0x4 + (ch) * 3)		// DATA_LOW, DATA_HIGH, HYSTERESIS per channel
+#define AD7992_REG_COUNT				(0x8)
+
+#define AD7992_CONFIG_CH1				(0x10)
+#define AD7992_CONFIG_CH2				(0x20)
+#define AD7992_CONFIG_FLTR				(0x08)
+#define AD7992_CONFIG_ALERT_EN			(0x04)		// ALERT/BUSY pin as an active low alert output
+
+// Mode 2: writing the channel bits into the address pointer converts each selected channel,
+// and the results are read back in channel order
+#define AD7992_POINTER_CHANNELS(mask)	((uint8_t)(((mask) & GroveAD7992_Channel_All) << 4))
 
 #define CONVST_PIN   58
 #define ALART_PIN    57
 
 #define REF_VOL  3300
 
-typedef struct
+// A result converted alongside the requested channel is handed to the next read of its channel within this window
+#define AD7992_PAIR_WINDOW_US			(5000)
+
+typedef struct GroveAD7992Instance
 {
+	struct GroveAD7992Instance* Next;
+	int RefCount;
 	int I2cFd;
+	uint8_t Address;
 	int ConvstFd;
 	int AlertFd;
+	void* Regs;			// register shadow, the configuration is written once and shared by every channel
+	uint8_t Claimed;		// channels with a sensor attached, converted together on every read
+	uint8_t ClaimCount[2];	// sensors attached to VIN1 and VIN2
+	uint8_t Pending;		// channels whose result from the last sequence has not been read yet
+	GroveAD7992Sample Last[2];
+	uint8_t AlertChannels;	// channels under automatic conversion, 0 when alerts are off
+	GroveAD7992_AlertHandler AlertHandler;
+	void* AlertContext;
 }
 GroveAD7992Instance;
 
+// One instance per ADC: the CONVST and ALERT GPIOs can only be opened once
+static GroveAD7992Instance* devices;
+
 void* GroveAD7992_Open(int i2cFd)
 {
+	for (GroveAD7992Instance* it = devices; it != NULL; it = it->Next)
+	{
+		if (it->I2cFd == i2cFd && it->Address == AD7992_ADDRESS)
+		{
+			it->RefCount++;
+			return it;
+		}
+	}
+
 	GroveAD7992Instance* this = (GroveAD7992Instance*)malloc(sizeof(GroveAD7992Instance));
+	if (this == NULL) return NULL;
+	memset(this, 0, sizeof(*this));
+
+	this->Regs = GroveRegShadow_Open(i2cFd, AD7992_ADDRESS, AD7992_REG_COUNT);
+	if (this->Regs == NULL)
+	{
+		free(this);
+		return NULL;
+	}
 
+	this->Next = devices;
+	devices = this;
+	this->RefCount = 1;
 	this->I2cFd = i2cFd;
+	this->Address = AD7992_ADDRESS;
 	this->ConvstFd = GPIO_OpenAsOutput(CONVST_PIN, GPIO_OutputMode_PushPull, GPIO_Value_High);
 	this->AlertFd = GPIO_OpenAsInput(ALART_PIN);
 
 	return this;
 }
 
+void GroveAD7992_Close(void* inst)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	if (this == NULL || --this->RefCount > 0) return;
+
+	GroveAD7992_StopAlerts(this);
+
+	for (GroveAD7992Instance** it = &devices; *it != NULL; it = &(*it)->Next)
+	{
+		if (*it == this)
+		{
+			*it = this->Next;
+			break;
+		}
+	}
+	if (this->ConvstFd >= 0) close(this->ConvstFd);
+	if (this->AlertFd >= 0) close(this->AlertFd);
+	GroveRegShadow_Close(this->Regs);
+	free(this);
+}
+
+void GroveAD7992_ClaimChannel(void* inst, int channel)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	if (this == NULL) return;
+
+	int index = channel == 0 ? 0 : 1;
+	this->ClaimCount[index]++;
+	this->Claimed |= index == 0 ? GroveAD7992_Channel_1 : GroveAD7992_Channel_2;
+}
+
+void GroveAD7992_ReleaseChannel(void* inst, int channel)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	if (this == NULL) return;
+
+	int index = channel == 0 ? 0 : 1;
+	if (this->ClaimCount[index] == 0 || --this->ClaimCount[index] > 0) return;
+
+	// The last sensor on the channel is gone; reads stop converting it
+	this->Claimed &= (uint8_t)~(index == 0 ? GroveAD7992_Channel_1 : GroveAD7992_Channel_2);
+}
+
+static uint32_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000);
+}
+
+static int channel_count(uint8_t channelMask)
+{
+	return (channelMask & GroveAD7992_Channel_1 ? 1 : 0) + (channelMask & GroveAD7992_Channel_2 ? 1 : 0);
+}
+
+// One mode 2 cycle: a single write-read converts and returns every channel in channelMask
+static int convert_sequence(GroveAD7992Instance* this, uint8_t channelMask, GroveAD7992Sample* samples)
+{
+	const uint8_t pointer = AD7992_POINTER_CHANNELS(channelMask);
+	uint8_t data[4];
+	int count = channel_count(channelMask);
+
+	uint32_t timestamp = now_us();
+	if (!GroveI2C_WriteRead(this->I2cFd, AD7992_ADDRESS, &pointer, 1, data, count * 2)) return 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		uint16_t word = (uint16_t)(data[i * 2] << 8 | data[i * 2 + 1]);
+		samples[i].TimestampUs = timestamp;
+		samples[i].Channel = (uint8_t)((word >> 12) & 0x3);
+		samples[i].Raw = (uint16_t)(word & 0x0fff);
+	}
+
+	return count;
+}
+
+int GroveAD7992_Sample(void* inst, uint8_t channelMask, uint32_t rateHz, GroveAD7992Sample* samples, int count)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+
+	channelMask &= GroveAD7992_Channel_All;
+	if (channelMask == 0 || count <= 0) return 0;
+
+	// Both channels stay selected for the whole capture; the shadow drops the write when nothing changed.
+	// While alerts are on the configuration belongs to the cycle timer and the pointer alone selects channels.
+	if (this->AlertChannels == 0)
+	{
+		GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CONFIGURATION, AD7992_CONFIG_CH1 | AD7992_CONFIG_CH2 | AD7992_CONFIG_FLTR);
+	}
+	this->Pending = 0;
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	const long periodNs = rateHz > 0 ? (long)(1000000000UL / rateHz) : 0;
+
+	int filled = 0;
+	while (filled < count)
+	{
+		// The last cycle converts only the channels that still fit
+		uint8_t mask = channelMask;
+		if (count - filled < channel_count(mask)) mask = (channelMask & GroveAD7992_Channel_1) ? GroveAD7992_Channel_1 : GroveAD7992_Channel_2;
+
+		int converted = convert_sequence(this, mask, &samples[filled]);
+		if (converted == 0) break;
+		filled += converted;
+
+		if (periodNs > 0 && filled < count)
+		{
+			// Absolute deadlines, so bus time does not stretch the period
+			deadline.tv_nsec += periodNs;
+			while (deadline.tv_nsec >= 1000000000L)
+			{
+				deadline.tv_nsec -= 1000000000L;
+				deadline.tv_sec++;
+			}
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+		}
+	}
+
+	return filled;
+}
+
 float GroveAD7992_Read(void* inst, int channel)
 {
 	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	const uint8_t requested = channel == 0 ? GroveAD7992_Channel_1 : GroveAD7992_Channel_2;
+	const int index = channel == 0 ? 0 : 1;
 
-	// Select channel
-	GroveI2C_WriteReg8(this->I2cFd, AD7992_ADDRESS, AD7992_REG_CONFIGURATION, (channel == 0 ? 0x10 : 0x20) | 0x08);
+	// Sequencing, the pending results and the read-back must not interleave with another thread's access to the ADC
+	GroveI2CBus_Lock(this->I2cFd, AD7992_ADDRESS);
 
-	// Start conversion
-	GPIO_SetValue(this->ConvstFd, GPIO_Value_Low);
+	// Converted with another channel's read a moment ago
+	if ((this->Pending & requested) != 0)
+	{
+		this->Pending &= (uint8_t)~requested;
+		if (now_us() - this->Last[index].TimestampUs <= AD7992_PAIR_WINDOW_US)
+		{
+			uint16_t raw = this->Last[index].Raw;
+			GroveI2CBus_Unlock(this->I2cFd);
+			return GroveAD7992_RawToFloat(raw);
+		}
+	}
 
-	// Wait for converted
-	const struct timespec t_convert = { 0, 2000 };
-	nanosleep(&t_convert, NULL);
+	// Written once; while alerts are on the configuration belongs to the cycle timer
+	if (this->AlertChannels == 0)
+	{
+		GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CONFIGURATION, AD7992_CONFIG_CH1 | AD7992_CONFIG_CH2 | AD7992_CONFIG_FLTR);
+	}
 
-	// Read value
-	uint16_t val;
-	GroveI2C_ReadReg16(this->I2cFd, AD7992_ADDRESS, AD7992_REG_CONVERSION_RESULT, &val);
+	// Every claimed channel is converted in the same cycle; the others wait for their sensor's next read
+	GroveAD7992Sample samples[2];
+	int count = convert_sequence(this, (uint8_t)(this->Claimed | requested), samples);
 
-	// Stop conversion
-	GPIO_SetValue(this->ConvstFd, GPIO_Value_High);
+	float value = 0.0f;
+	this->Pending = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int c = samples[i].Channel & 1;
+		if (c == index)
+		{
+			value = GroveAD7992_RawToFloat(samples[i].Raw);
+		}
+		else
+		{
+			this->Last[c] = samples[i];
+			this->Pending |= (uint8_t)(1 << c);
+		}
+	}
 
-	val = (uint16_t)((val & 0x00ff) << 8 | (val & 0xff00) >> 8);
-	val &= 0x0fff;
+	GroveI2CBus_Unlock(this->I2cFd);
+
+	return value;
+}
+
+float GroveAD7992_RawToFloat(uint16_t raw)
+{
+	return (float)(raw & 0x0fff) / 0x0fff;
+}
+
+static void write_reg16(GroveAD7992Instance* this, uint8_t reg, uint16_t val)
+{
+	const uint8_t data[3] = { reg, (uint8_t)(val >> 8), (uint8_t)val };
+	GroveI2C_WriteBytes(this->I2cFd, AD7992_ADDRESS, data, sizeof(data));
+}
+
+void GroveAD7992_SetLimits(void* inst, int channel, uint16_t low, uint16_t high, uint16_t hysteresis)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	const uint8_t reg = (uint8_t)AD7992_REG_DATA_LOW(channel == 0 ? 0 : 1);
+
+	write_reg16(this, reg, low & 0x0fff);
+	write_reg16(this, (uint8_t)(reg + 1), high & 0x0fff);
+	write_reg16(this, (uint8_t)(reg + 2), hysteresis & 0x0fff);
+}
+
+bool GroveAD7992_StartAlerts(void* inst, uint8_t channelMask, GroveAD7992_Cycle cycle, GroveAD7992_AlertHandler handler, void* context)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+
+	channelMask &= GroveAD7992_Channel_All;
+	if (channelMask == 0 || cycle == GroveAD7992_Cycle_Off)
+	{
+		GroveAD7992_StopAlerts(inst);
+		return true;
+	}
+
+	// Without the ALERT pin (e.g. GPIO 57 missing from the app manifest) crossings could never be seen
+	if (this->AlertFd < 0) return false;
+
+	this->AlertHandler = handler;
+	this->AlertContext = context;
+	this->AlertChannels = channelMask;
+
+	GroveI2CBus_Lock(this->I2cFd, AD7992_ADDRESS);
+
+	// Start from a clean status so the first assertion is a fresh crossing
+	const uint8_t clear[2] = { AD7992_REG_ALERT_STATUS, 0xff };
+	bool ok = GroveI2C_WriteBytes(this->I2cFd, AD7992_ADDRESS, clear, sizeof(clear));
+
+	// Mode 3: the cycle timer converts the configured channels on its own and checks them against the limits
+	ok = ok && GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CONFIGURATION, (uint8_t)(channelMask << 4) | AD7992_CONFIG_FLTR | AD7992_CONFIG_ALERT_EN);
+	ok = ok && GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CYCLE_TIMER, (uint8_t)cycle);
+
+	GroveI2CBus_Unlock(this->I2cFd);
+
+	// A half-configured cycle timer is put back to off rather than left converting unseen
+	if (!ok) GroveAD7992_StopAlerts(this);
+	return ok;
+}
+
+void GroveAD7992_StopAlerts(void* inst)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	if (this->AlertChannels == 0) return;
+
+	GroveI2CBus_Lock(this->I2cFd, AD7992_ADDRESS);
+	GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CYCLE_TIMER, (uint8_t)GroveAD7992_Cycle_Off);
+	GroveRegShadow_WriteReg8(this->Regs, AD7992_REG_CONFIGURATION, (uint8_t)(this->AlertChannels << 4) | AD7992_CONFIG_FLTR);
+	GroveI2CBus_Unlock(this->I2cFd);
+
+	this->AlertChannels = 0;
+	this->AlertHandler = NULL;
+	this->AlertContext = NULL;
+}
+
+int GroveAD7992_PollAlerts(void* inst)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
+	if (this->AlertChannels == 0 || this->AlertFd < 0) return 0;
+
+	// Only the GPIO is read while the inputs stay within their limits
+	GPIO_Value_Type pin;
+	if (GPIO_GetValue(this->AlertFd, &pin) != 0) return -1;
+	if (pin != GPIO_Value_Low) return 0;
+
+	GroveI2CBus_Lock(this->I2cFd, AD7992_ADDRESS);
+
+	const uint8_t reg = AD7992_REG_ALERT_STATUS;
+	uint8_t status;
+	if (!GroveI2C_WriteRead(this->I2cFd, AD7992_ADDRESS, &reg, 1, &status, 1))
+	{
+		GroveI2CBus_Unlock(this->I2cFd);
+		return -1;
+	}
+
+	// Writing the flags back clears them and releases the pin
+	status &= 0x0f;
+	if (status != 0)
+	{
+		const uint8_t clear[2] = { AD7992_REG_ALERT_STATUS, status };
+		GroveI2C_WriteBytes(this->I2cFd, AD7992_ADDRESS, clear, sizeof(clear));
+	}
+
+	GroveI2CBus_Unlock(this->I2cFd);
+
+	// Status bits: CH1 low, CH1 high, CH2 low, CH2 high
+	int events = 0;
+	for (int bit = 0; bit < 4; bit++)
+	{
+		if ((status & (1 << bit)) == 0) continue;
+		if (this->AlertHandler != NULL)
+		{
+			this->AlertHandler(this->AlertContext, bit / 2, (bit & 1) ? GroveAD7992_Alert_High : GroveAD7992_Alert_Low);
+		}
+		events++;
+	}
+
+	return events;
+}
+
+void GroveAD7992_InvalidateCache(void* inst)
+{
+	GroveAD7992Instance* this = (GroveAD7992Instance*)inst;
 
-	return (float)val / 0x0fff;
+	GroveRegShadow_Invalidate(this->Regs);
 }
 
 float GroveAD7992_ConvertToMillisVolt(float value)
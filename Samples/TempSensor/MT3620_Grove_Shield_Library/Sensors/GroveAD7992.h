@@ -2,7 +2,78 @@
 
 #include "../applibs_versions.h"
 #include <applibs/gpio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
+typedef enum
+{
+	GroveAD7992_Channel_1 = 0x1,		// VIN1, analog pin 0
+	GroveAD7992_Channel_2 = 0x2,		// VIN2, analog pin 1
+	GroveAD7992_Channel_All = 0x3
+}
+GroveAD7992_Channel;
+
+typedef struct
+{
+	uint32_t TimestampUs;		// CLOCK_MONOTONIC when the conversion was started
+	uint8_t Channel;			// 0 = VIN1, 1 = VIN2, as reported by the ADC
+	uint16_t Raw;				// 12-bit result
+}
+GroveAD7992Sample;
+
+// Automatic conversion interval in alert mode, in multiples of the conversion time (about 2 us)
+typedef enum
+{
+	GroveAD7992_Cycle_Off,
+	GroveAD7992_Cycle_X32,
+	GroveAD7992_Cycle_X64,
+	GroveAD7992_Cycle_X128,
+	GroveAD7992_Cycle_X256,
+	GroveAD7992_Cycle_X512,
+	GroveAD7992_Cycle_X1024,
+	GroveAD7992_Cycle_X2048
+}
+GroveAD7992_Cycle;
+
+typedef enum
+{
+	GroveAD7992_Alert_Low,		// result fell below DATA_LOW
+	GroveAD7992_Alert_High		// result rose above DATA_HIGH
+}
+GroveAD7992_Alert;
+
+// channel: 0 = VIN1, 1 = VIN2
+typedef void(*GroveAD7992_AlertHandler)(void* context, int channel, GroveAD7992_Alert alert);
+
+// Instances are shared per bus and address and reference counted: every Open needs a matching Close.
 void* GroveAD7992_Open(int i2cFd);
+void GroveAD7992_Close(void* inst);
+
+// Marks a channel as in use by a sensor. Reads convert all claimed channels in one cycle and keep the other results
+// for a few milliseconds, so reading a light and a rotary sensor back to back costs one conversion.
+// Claims are counted; each needs a matching GroveAD7992_ReleaseChannel before the sensor closes the ADC.
+void GroveAD7992_ClaimChannel(void* inst, int channel);
+void GroveAD7992_ReleaseChannel(void* inst, int channel);
 float GroveAD7992_Read(void* inst, int channel);
+
+// Fills samples with up to count raw results using the ADC's channel sequencing: every cycle converts all channels
+// in channelMask with one bus transaction. Cycles start rateHz times per second (0 = back to back).
+// Returns the number of samples filled, fewer than count if the bus failed.
+int GroveAD7992_Sample(void* inst, uint8_t channelMask, uint32_t rateHz, GroveAD7992Sample* samples, int count);
+float GroveAD7992_RawToFloat(uint16_t raw);
+
+// Limits in raw 12-bit counts. After an alert the ADC only re-arms once the result is back inside the window by hysteresis.
+void GroveAD7992_SetLimits(void* inst, int channel, uint16_t low, uint16_t high, uint16_t hysteresis);
+
+// Lets the ADC convert channelMask on its own every cycle and raise the ALERT pin (GPIO 57) on a limit crossing.
+// Call GroveAD7992_PollAlerts from an event loop timer; it only touches the bus when the pin is asserted,
+// then delivers one handler call per crossing. Returns the number of crossings, or -1 on error.
+// StartAlerts returns false, and leaves alerts off, when the ALERT GPIO could not be opened or the ADC did not
+// acknowledge the configuration.
+bool GroveAD7992_StartAlerts(void* inst, uint8_t channelMask, GroveAD7992_Cycle cycle, GroveAD7992_AlertHandler handler, void* context);
+void GroveAD7992_StopAlerts(void* inst);
+int GroveAD7992_PollAlerts(void* inst);
+
+// Forget the cached configuration, e.g. after the ADC was reset; the next read rewrites it.
+void GroveAD7992_InvalidateCache(void* inst);
 float GroveAD7992_ConvertToMillisVolt(float value);
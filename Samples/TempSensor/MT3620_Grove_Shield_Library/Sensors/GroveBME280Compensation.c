@@ -0,0 +1,136 @@
+#include "GroveBME280Compensation.h"
+
+#ifndef GROVE_BME280_NO_FLOAT
+#include <math.h>
+#endif
+
+static uint16_t le16(const uint8_t* p)
+{
+	return (uint16_t)(p[1] << 8 | p[0]);
+}
+
+void GroveBME280Compensation_ParseCalibration(GroveBME280Calibration* cal, const uint8_t* c, const uint8_t* h)
+{
+	cal->dig_T1 = le16(&c[0]);
+	cal->dig_T2 = (int16_t)le16(&c[2]);
+	cal->dig_T3 = (int16_t)le16(&c[4]);
+	cal->dig_P1 = le16(&c[6]);
+	cal->dig_P2 = (int16_t)le16(&c[8]);
+	cal->dig_P3 = (int16_t)le16(&c[10]);
+	cal->dig_P4 = (int16_t)le16(&c[12]);
+	cal->dig_P5 = (int16_t)le16(&c[14]);
+	cal->dig_P6 = (int16_t)le16(&c[16]);
+	cal->dig_P7 = (int16_t)le16(&c[18]);
+	cal->dig_P8 = (int16_t)le16(&c[20]);
+	cal->dig_P9 = (int16_t)le16(&c[22]);
+	cal->dig_H1 = c[25];
+	cal->dig_H2 = (int16_t)le16(&h[0]);
+	cal->dig_H3 = h[2];
+	// dig_H4 and dig_H5 are 12-bit signed values sharing 0xE5
+	cal->dig_H4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F));
+	cal->dig_H5 = (int16_t)((int8_t)h[5] * 16 | (h[4] >> 4));
+	cal->dig_H6 = (int8_t)h[6];
+}
+
+void GroveBME280Compensation_ParseData(GroveBME280Raw* raw, const uint8_t* data)
+{
+	raw->Pressure = (int32_t)((uint32_t)data[0] << 12 | (uint32_t)data[1] << 4 | data[2] >> 4);
+	raw->Temperature = (int32_t)((uint32_t)data[3] << 12 | (uint32_t)data[4] << 4 | data[5] >> 4);
+	raw->Humidity = (int32_t)((uint32_t)data[6] << 8 | data[7]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Integer (Bosch reference; left shifts of signed values written as multiplications)
+
+int32_t GroveBME280Compensation_TemperatureInt(const GroveBME280Calibration* cal, int32_t adc_T, int32_t* t_fine)
+{
+	int32_t var1 = (((adc_T >> 3) - ((int32_t)cal->dig_T1 * 2)) * (int32_t)cal->dig_T2) >> 11;
+	int32_t var2 = (((((adc_T >> 4) - (int32_t)cal->dig_T1) * ((adc_T >> 4) - (int32_t)cal->dig_T1)) >> 12) * (int32_t)cal->dig_T3) >> 14;
+
+	*t_fine = var1 + var2;
+	return (*t_fine * 5 + 128) >> 8;
+}
+
+uint32_t GroveBME280Compensation_PressureInt(const GroveBME280Calibration* cal, int32_t adc_P, int32_t t_fine)
+{
+	int64_t var1 = (int64_t)t_fine - 128000;
+	int64_t var2 = var1 * var1 * (int64_t)cal->dig_P6;
+	var2 = var2 + var1 * (int64_t)cal->dig_P5 * 131072;
+	var2 = var2 + (int64_t)cal->dig_P4 * 34359738368LL;
+	var1 = ((var1 * var1 * (int64_t)cal->dig_P3) >> 8) + var1 * (int64_t)cal->dig_P2 * 4096;
+	var1 = ((140737488355328LL + var1) * (int64_t)cal->dig_P1) >> 33;
+
+	// Avoid division by zero on an unprogrammed part
+	if (var1 == 0) return 0;
+
+	int64_t p = 1048576 - adc_P;
+	p = ((p * 2147483648LL - var2) * 3125) / var1;
+	var1 = ((int64_t)cal->dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+	var2 = ((int64_t)cal->dig_P8 * p) >> 19;
+
+	return (uint32_t)(((p + var1 + var2) >> 8) + (int64_t)cal->dig_P7 * 16);
+}
+
+uint32_t GroveBME280Compensation_HumidityInt(const GroveBME280Calibration* cal, int32_t adc_H, int32_t t_fine)
+{
+	int32_t v = t_fine - 76800;
+	v = ((((adc_H * 16384) - ((int32_t)cal->dig_H4 * 1048576) - ((int32_t)cal->dig_H5 * v)) + 16384) >> 15) *
+		(((((((v * (int32_t)cal->dig_H6) >> 10) * (((v * (int32_t)cal->dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
+			(int32_t)cal->dig_H2 + 8192) >> 14);
+	v = v - (((((v >> 15) * (v >> 15)) >> 7) * (int32_t)cal->dig_H1) >> 4);
+
+	if (v < 0) v = 0;
+	if (v > 419430400) v = 419430400;
+
+	return (uint32_t)(v >> 12);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Double precision (datasheet 8.1)
+
+#ifndef GROVE_BME280_NO_FLOAT
+
+double GroveBME280Compensation_Temperature(const GroveBME280Calibration* cal, int32_t adc_T, double* t_fine)
+{
+	double var1 = ((double)adc_T / 16384.0 - (double)cal->dig_T1 / 1024.0) * (double)cal->dig_T2;
+	double var2 = ((double)adc_T / 131072.0 - (double)cal->dig_T1 / 8192.0);
+	var2 = var2 * var2 * (double)cal->dig_T3;
+
+	*t_fine = var1 + var2;
+	return (var1 + var2) / 5120.0;
+}
+
+double GroveBME280Compensation_Pressure(const GroveBME280Calibration* cal, int32_t adc_P, double t_fine)
+{
+	double var1 = t_fine / 2.0 - 64000.0;
+	double var2 = var1 * var1 * (double)cal->dig_P6 / 32768.0;
+	var2 = var2 + var1 * (double)cal->dig_P5 * 2.0;
+	var2 = var2 / 4.0 + (double)cal->dig_P4 * 65536.0;
+	var1 = ((double)cal->dig_P3 * var1 * var1 / 524288.0 + (double)cal->dig_P2 * var1) / 524288.0;
+	var1 = (1.0 + var1 / 32768.0) * (double)cal->dig_P1;
+
+	// Avoid division by zero on an unprogrammed part
+	if (var1 == 0.0) return NAN;
+
+	double p = 1048576.0 - (double)adc_P;
+	p = (p - var2 / 4096.0) * 6250.0 / var1;
+	var1 = (double)cal->dig_P9 * p * p / 2147483648.0;
+	var2 = p * (double)cal->dig_P8 / 32768.0;
+
+	return p + (var1 + var2 + (double)cal->dig_P7) / 16.0;
+}
+
+double GroveBME280Compensation_Humidity(const GroveBME280Calibration* cal, int32_t adc_H, double t_fine)
+{
+	double h = t_fine - 76800.0;
+	h = ((double)adc_H - ((double)cal->dig_H4 * 64.0 + (double)cal->dig_H5 / 16384.0 * h)) *
+		((double)cal->dig_H2 / 65536.0 * (1.0 + (double)cal->dig_H6 / 67108864.0 * h * (1.0 + (double)cal->dig_H3 / 67108864.0 * h)));
+	h = h * (1.0 - (double)cal->dig_H1 * h / 524288.0);
+
+	if (h > 100.0) h = 100.0;
+	else if (h < 0.0) h = 0.0;
+
+	return h;
+}
+
+#endif
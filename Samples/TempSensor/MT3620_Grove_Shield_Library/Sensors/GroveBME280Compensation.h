@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+// BME280 compensation kernels (datasheet section 8 / Bosch reference driver), shared by the driver and host tools.
+// The integer kernels need no FPU: temperature in 0.01 degC, pressure in Pa/256 (Q24.8), humidity in %RH/1024 (Q22.10).
+// Defining GROVE_BME280_NO_FLOAT drops the double-precision kernels and the driver's float getters.
+
+#define GROVE_BME280_CALIB00_SIZE	26	// 0x88..0xA1
+#define GROVE_BME280_CALIB26_SIZE	7	// 0xE1..0xE7
+
+typedef struct
+{
+	uint16_t dig_T1;
+	int16_t dig_T2;
+	int16_t dig_T3;
+	uint16_t dig_P1;
+	int16_t dig_P2;
+	int16_t dig_P3;
+	int16_t dig_P4;
+	int16_t dig_P5;
+	int16_t dig_P6;
+	int16_t dig_P7;
+	int16_t dig_P8;
+	int16_t dig_P9;
+	uint8_t dig_H1;
+	int16_t dig_H2;
+	uint8_t dig_H3;
+	int16_t dig_H4;
+	int16_t dig_H5;
+	int8_t dig_H6;
+}
+GroveBME280Calibration;
+
+typedef struct
+{
+	int32_t Pressure;		// 20-bit adc_P
+	int32_t Temperature;	// 20-bit adc_T
+	int32_t Humidity;		// 16-bit adc_H
+}
+GroveBME280Raw;
+
+void GroveBME280Compensation_ParseCalibration(GroveBME280Calibration* cal, const uint8_t* calib00, const uint8_t* calib26);
+
+// Unpacks the 8-byte burst from 0xF7.
+void GroveBME280Compensation_ParseData(GroveBME280Raw* raw, const uint8_t* data);
+
+int32_t GroveBME280Compensation_TemperatureInt(const GroveBME280Calibration* cal, int32_t adc_T, int32_t* t_fine);
+uint32_t GroveBME280Compensation_PressureInt(const GroveBME280Calibration* cal, int32_t adc_P, int32_t t_fine);
+uint32_t GroveBME280Compensation_HumidityInt(const GroveBME280Calibration* cal, int32_t adc_H, int32_t t_fine);
+
+#ifndef GROVE_BME280_NO_FLOAT
+double GroveBME280Compensation_Temperature(const GroveBME280Calibration* cal, int32_t adc_T, double* t_fine);
+double GroveBME280Compensation_Pressure(const GroveBME280Calibration* cal, int32_t adc_P, double t_fine);
+double GroveBME280Compensation_Humidity(const GroveBME280Calibration* cal, int32_t adc_H, double t_fine);
+#endif
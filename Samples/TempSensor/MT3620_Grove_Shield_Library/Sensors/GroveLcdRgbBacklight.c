@@ -1,9 +1,14 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 #include "../HAL/GroveI2C.h"
+#include "../HAL/GroveRegShadow.h"
 #include "../Common/Delay.h"
 #include "GroveLcdRgbBacklight.h"
 
@@ -13,6 +18,7 @@
 #define RED_CMD 4
 #define GRN_CMD 3
 #define BLU_CMD 2
+#define RGB_REG_COUNT	13	// PCA9633 MODE1..ALLCALLADR
 
 #define TEXT_CMD        0x80
 #define CLEAR_CMD       0x01
@@ -23,10 +29,56 @@
 
 #define LCD_WIDTH   16
 #define LCD_HEIGHT   2
+#define LCD_LINE2    0x40   // DDRAM address of the second line
+#define LCD_RUN_GAP  4      // unchanged cells that are cheaper to resend than to start another addressed write
+
+#define CGRAM_CMD        0x40
+#define GLYPH_SLOTS      8
+#define GLYPH_CODE       8      // slots are shown through codes 8..15, which alias CGRAM 0..7 and are never NUL
+#define FULL_BLOCK_CHAR  0xFF   // built-in all-pixels character of the A00 character ROM
+
+#define ANIMATE_DEFAULT_HZ  50
+
+typedef enum
+{
+	Animation_None,
+	Animation_Fade,
+	Animation_Pulse,
+	Animation_Flash
+}
+Animation;
 
 typedef struct
 {
 	int I2cFd;
+	void* Backlight;		// PCA9633 register shadow
+
+	// Text shadow: what the application wrote and what the controller shows. GlassKnown is false until the glass
+	// contents are known again, e.g. after an invalidate, and the next update then rewrites every cell.
+	uint8_t Screen[LCD_HEIGHT][LCD_WIDTH];
+	uint8_t Glass[LCD_HEIGHT][LCD_WIDTH];
+	bool GlassKnown;
+
+	// CGRAM glyph cache: pattern held by each slot and when it was last asked for (least recently used goes first)
+	uint8_t GlyphPattern[GLYPH_SLOTS][8];
+	bool GlyphResident[GLYPH_SLOTS];
+	uint32_t GlyphLastUse[GLYPH_SLOTS];
+	uint32_t GlyphClock;
+
+	// Backlight animation. Color is what was last set, Base the color an animation returns to (or, for a fade,
+	// ends on). Steps are computed from the start time, so a late call catches up instead of stretching the animation.
+	uint8_t Color[3];
+	uint8_t Base[3];
+	uint8_t From[3];
+	uint8_t To[3];
+	Animation Kind;
+	GroveLcdRgbBacklight_Ease Ease;
+	uint64_t StartUs;
+	uint64_t LastStepUs;
+	uint32_t MinStepUs;
+	uint32_t OnMs;			// fade duration, pulse period or flash on time
+	uint32_t OffMs;			// flash off time
+	int Count;				// pulses or flashes, 0 repeats until another color is set
 }
 GroveLcdRgbBacklightInstance;
 
@@ -39,6 +91,8 @@ static void SendCommand(GroveLcdRgbBacklightInstance* this, uint8_t addr, uint8_
 void* GroveLcdRgbBacklight_Open(int i2cFd)
 {
     GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)malloc(sizeof(GroveLcdRgbBacklightInstance));
+	if (this == NULL) return NULL;
+	memset(this, 0, sizeof(*this));
 
 	this->I2cFd = i2cFd;
 
@@ -62,29 +116,343 @@ void* GroveLcdRgbBacklight_Open(int i2cFd)
 
     GroveLcdRgbBacklight_ClearDisplay(this);
 
+	this->MinStepUs = 1000000 / ANIMATE_DEFAULT_HZ;
+
+	// Opened after the raw init writes above, so every register starts out unknown
+	this->Backlight = GroveRegShadow_Open(i2cFd, RGBADDR, RGB_REG_COUNT);
+	if (this->Backlight == NULL)
+	{
+		free(this);
+		return NULL;
+	}
+
 	return this;
 }
 
-void GroveLcdRgbBacklight_ClearDisplay(void *this)
+void GroveLcdRgbBacklight_ClearDisplay(void *inst)
 {
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
     uint8_t command_3[2] = { TEXT_CMD, CLEAR_CMD };
 
     SendCommand(this, TXTADDR, command_3, 2);
+
+	memset(this->Screen, ' ', sizeof(this->Screen));
+	memset(this->Glass, ' ', sizeof(this->Glass));
+	this->GlassKnown = true;
+}
+
+void GroveLcdRgbBacklight_ClearText(void *inst)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	memset(this->Screen, ' ', sizeof(this->Screen));
+}
+
+int GroveLcdRgbBacklight_Printf(void *inst, int row, int column, const char *format, ...)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	char text[LCD_HEIGHT * (LCD_WIDTH + 1) + 1];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	if (length < 0) return -1;
+
+	// '\n' continues at the start of the next line, text past the end of a line is dropped
+	int placed = 0;
+	for (const char *c = text; *c != '\0' && row >= 0 && row < LCD_HEIGHT; c++)
+	{
+		if (*c == '\n')
+		{
+			row++;
+			column = 0;
+		}
+		else if (column >= 0 && column < LCD_WIDTH)
+		{
+			this->Screen[row][column++] = (uint8_t)*c;
+			placed++;
+		}
+		else
+		{
+			column++;
+		}
+	}
+	return placed;
+}
+
+static bool CellChanged(GroveLcdRgbBacklightInstance* this, int row, int column)
+{
+	return !this->GlassKnown || this->Screen[row][column] != this->Glass[row][column];
+}
+
+int GroveLcdRgbBacklight_Update(void *inst)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	int sent = 0;
+	for (int row = 0; row < LCD_HEIGHT; row++)
+	{
+		for (int start = 0; start < LCD_WIDTH; start++)
+		{
+			if (!CellChanged(this, row, start)) continue;
+
+			// Extend the run over short stretches of unchanged cells
+			int end = start;
+			for (int column = start + 1; column < LCD_WIDTH && column - end <= LCD_RUN_GAP + 1; column++)
+			{
+				if (CellChanged(this, row, column)) end = column;
+			}
+			int count = end - start + 1;
+
+			// Set DDRAM address, then a data control byte with Co = 0 streams the run
+			uint8_t frame[3 + LCD_WIDTH] = { TEXT_CMD, (uint8_t)(0x80 | ((row ? LCD_LINE2 : 0) + start)), CHAR_CMD };
+			memcpy(&frame[3], &this->Screen[row][start], (size_t)count);
+			SendCommand(this, TXTADDR, frame, (uint8_t)(3 + count));
+
+			memcpy(&this->Glass[row][start], &this->Screen[row][start], (size_t)count);
+			sent += count;
+			start = end;
+		}
+	}
+	this->GlassKnown = true;
+
+	return sent;
+}
+
+static void WriteBacklight(GroveLcdRgbBacklightInstance* this, const uint8_t color[3])
+{
+	// Only the channels that changed go out
+	GroveRegShadow_WriteReg8(this->Backlight, RED_CMD, color[0]);
+	GroveRegShadow_WriteReg8(this->Backlight, GRN_CMD, color[1]);
+	GroveRegShadow_WriteReg8(this->Backlight, BLU_CMD, color[2]);
+	memcpy(this->Color, color, 3);
 }
 
-void GroveLcdRgbBacklight_SetBacklightRgb(void *this, uint8_t red, uint8_t green, uint8_t blue)
+void GroveLcdRgbBacklight_SetBacklightRgb(void *inst, uint8_t red, uint8_t green, uint8_t blue)
 {
-    uint8_t command[2] = { RED_CMD, red };
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
 
-    SendCommand(this, RGBADDR, command, 2);
+	const uint8_t color[3] = { red, green, blue };
+	this->Kind = Animation_None;
+	memcpy(this->Base, color, 3);
+	WriteBacklight(this, color);
+}
+
+static uint64_t NowUs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void StartAnimation(GroveLcdRgbBacklightInstance* this, Animation kind, uint8_t red, uint8_t green, uint8_t blue,
+	GroveLcdRgbBacklight_Ease ease)
+{
+	memcpy(this->From, this->Color, 3);
+	this->To[0] = red;
+	this->To[1] = green;
+	this->To[2] = blue;
+	this->Kind = kind;
+	this->Ease = ease;
+	this->StartUs = NowUs();
+	this->LastStepUs = 0;
+}
+
+void GroveLcdRgbBacklight_FadeTo(void *inst, uint8_t red, uint8_t green, uint8_t blue, uint32_t durationMs, GroveLcdRgbBacklight_Ease ease)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	StartAnimation(this, Animation_Fade, red, green, blue, ease);
+	memcpy(this->Base, this->To, 3);
+	this->OnMs = durationMs;
+}
 
-    command[0] = GRN_CMD;
-    command[1] = green;
+void GroveLcdRgbBacklight_Pulse(void *inst, uint8_t red, uint8_t green, uint8_t blue, uint32_t periodMs, int count, GroveLcdRgbBacklight_Ease ease)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	StartAnimation(this, Animation_Pulse, red, green, blue, ease);
+	this->OnMs = periodMs > 0 ? periodMs : 1;
+	this->Count = count;
+}
+
+void GroveLcdRgbBacklight_Flash(void *inst, uint8_t red, uint8_t green, uint8_t blue, uint32_t onMs, uint32_t offMs, int count)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	StartAnimation(this, Animation_Flash, red, green, blue, GroveLcdRgbBacklight_Ease_Linear);
+	this->OnMs = onMs;
+	this->OffMs = onMs + offMs > 0 ? offMs : 1;		// keep the cycle non-empty
+	this->Count = count;
+}
+
+void GroveLcdRgbBacklight_SetMaxUpdateRate(void *inst, uint32_t hz)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	this->MinStepUs = hz > 0 ? 1000000 / hz : 0;
+}
+
+static float EaseCurve(GroveLcdRgbBacklight_Ease ease, float t)
+{
+	switch (ease)
+	{
+	case GroveLcdRgbBacklight_Ease_In:
+		return t * t;
+	case GroveLcdRgbBacklight_Ease_Out:
+		return t * (2.0f - t);
+	case GroveLcdRgbBacklight_Ease_InOut:
+		return t * t * (3.0f - 2.0f * t);
+	default:
+		return t;
+	}
+}
+
+static void Blend(uint8_t color[3], const uint8_t from[3], const uint8_t to[3], float k)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		color[i] = (uint8_t)lroundf(from[i] + (to[i] - from[i]) * k);
+	}
+}
+
+bool GroveLcdRgbBacklight_Animate(void *inst)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	if (this->Kind == Animation_None) return false;
+
+	uint64_t now = NowUs();
+	uint64_t elapsedMs = (now - this->StartUs) / 1000;
+	bool finished = false;
+	uint8_t color[3];
+
+	switch (this->Kind)
+	{
+	case Animation_Fade:
+		finished = elapsedMs >= this->OnMs;
+		Blend(color, this->From, this->To, finished ? 1.0f : EaseCurve(this->Ease, (float)elapsedMs / this->OnMs));
+		break;
+
+	case Animation_Pulse:
+	{
+		// Out to the pulse color and back within each period
+		finished = this->Count > 0 && elapsedMs >= (uint64_t)this->Count * this->OnMs;
+		float phase = (float)(elapsedMs % this->OnMs) / this->OnMs;
+		float k = phase < 0.5f ? phase * 2.0f : (1.0f - phase) * 2.0f;
+		Blend(color, this->Base, this->To, finished ? 0.0f : EaseCurve(this->Ease, k));
+		break;
+	}
+
+	default:
+	{
+		uint32_t cycleMs = this->OnMs + this->OffMs;
+		finished = this->Count > 0 && elapsedMs >= (uint64_t)this->Count * cycleMs;
+		memcpy(color, !finished && elapsedMs % cycleMs < this->OnMs ? this->To : this->Base, 3);
+		break;
+	}
+	}
+
+	// Rate cap, except for the step that lands the animation
+	if (!finished && this->LastStepUs != 0 && now - this->LastStepUs < this->MinStepUs) return true;
+
+	if (memcmp(color, this->Color, 3) != 0)
+	{
+		WriteBacklight(this, color);
+		this->LastStepUs = now;
+	}
+
+	if (finished) this->Kind = Animation_None;
+	return !finished;
+}
+
+void GroveLcdRgbBacklight_InvalidateCache(void *inst)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	GroveRegShadow_Invalidate(this->Backlight);
+	this->GlassKnown = false;
+	memset(this->GlyphResident, 0, sizeof(this->GlyphResident));
+}
+
+static bool GlyphOnScreen(GroveLcdRgbBacklightInstance* this, int slot)
+{
+	for (int row = 0; row < LCD_HEIGHT; row++)
+	{
+		for (int column = 0; column < LCD_WIDTH; column++)
+		{
+			uint8_t c = this->Screen[row][column];
+			if (c < GLYPH_CODE + GLYPH_SLOTS && (c & (GLYPH_SLOTS - 1)) == slot) return true;
+		}
+	}
+	return false;
+}
+
+int GroveLcdRgbBacklight_Glyph(void *inst, const uint8_t pattern[8])
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
+
+	this->GlyphClock++;
+
+	int victim = -1;
+	for (int slot = 0; slot < GLYPH_SLOTS; slot++)
+	{
+		if (this->GlyphResident[slot] && memcmp(this->GlyphPattern[slot], pattern, 8) == 0)
+		{
+			this->GlyphLastUse[slot] = this->GlyphClock;
+			return GLYPH_CODE + slot;
+		}
+
+		// Replacing a glyph that is on screen would change those cells as well
+		if (this->GlyphResident[slot] && GlyphOnScreen(this, slot)) continue;
+		if (victim < 0 || !this->GlyphResident[slot] ||
+			(this->GlyphResident[victim] && this->GlyphLastUse[slot] < this->GlyphLastUse[victim]))
+		{
+			victim = slot;
+		}
+	}
+	if (victim < 0) return -1;
+
+	// Set CGRAM address, then the eight rows as data; the next text update sets a DDRAM address again
+	uint8_t frame[3 + 8] = { TEXT_CMD, (uint8_t)(CGRAM_CMD | (victim << 3)), CHAR_CMD };
+	memcpy(&frame[3], pattern, 8);
+	SendCommand(this, TXTADDR, frame, sizeof(frame));
+
+	memcpy(this->GlyphPattern[victim], pattern, 8);
+	this->GlyphResident[victim] = true;
+	this->GlyphLastUse[victim] = this->GlyphClock;
+	return GLYPH_CODE + victim;
+}
+
+void GroveLcdRgbBacklight_BarGraph(void *inst, int row, int column, int width, int value, int max)
+{
+	GroveLcdRgbBacklightInstance* this = (GroveLcdRgbBacklightInstance*)inst;
 
-    SendCommand(this, RGBADDR, command, 2);
+	if (row < 0 || row >= LCD_HEIGHT || column < 0 || width <= 0 || max <= 0) return;
+	if (column + width > LCD_WIDTH) width = LCD_WIDTH - column;
 
-    command[0] = BLU_CMD;
-    command[1] = blue;
+	// Five pixel columns per cell: full cells use the ROM block, the partial cell one of four cached glyphs
+	if (value < 0) value = 0;
+	if (value > max) value = max;
+	int pixels = (int)((int64_t)value * width * 5 / max);
 
-    SendCommand(this, RGBADDR, command, 2);
+	for (int cell = 0; cell < width; cell++)
+	{
+		int lit = pixels - cell * 5;
+		uint8_t c = ' ';
+		if (lit >= 5)
+		{
+			c = FULL_BLOCK_CHAR;
+		}
+		else if (lit > 0)
+		{
+			uint8_t pattern[8];
+			memset(pattern, (0x1F << (5 - lit)) & 0x1F, sizeof(pattern));
+			int code = GroveLcdRgbBacklight_Glyph(this, pattern);
+			if (code >= 0) c = (uint8_t)code;
+		}
+		this->Screen[row][column + cell] = c;
+	}
 }
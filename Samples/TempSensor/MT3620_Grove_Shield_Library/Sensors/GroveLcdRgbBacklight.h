@@ -3,8 +3,54 @@
 //WIKI_URL          https://www.seeedstudio.com/Grove-LCD-RGB-Backlight-p-1643.html
 
 #pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
 void* GroveLcdRgbBacklight_Open(int i2cFd);
 
+// Clears the glass and the text shadow.
 void GroveLcdRgbBacklight_ClearDisplay(void *this);
 
-void GroveLcdRgbBacklight_SetBacklightRgb(void *this, uint8_t red, uint8_t green, uint8_t blue);
\ No newline at end of file
+// Text goes into a 16x2 shadow first. Printf places formatted text at row/column and returns the number of cells
+// written; GroveLcdRgbBacklight_Update then sends only the cells that differ from the glass, one addressed write
+// per run of changes, and returns the number of characters sent.
+void GroveLcdRgbBacklight_ClearText(void *this);
+int GroveLcdRgbBacklight_Printf(void *this, int row, int column, const char *format, ...);
+int GroveLcdRgbBacklight_Update(void *this);
+
+// Sets the color at once and stops any backlight animation.
+void GroveLcdRgbBacklight_SetBacklightRgb(void *this, uint8_t red, uint8_t green, uint8_t blue);
+
+// Backlight animations. Starting one replaces the previous one; nothing is sent until GroveLcdRgbBacklight_Animate,
+// which is meant to be called from a periodic timer (e.g. an epoll timerfd) and returns false once the animation is
+// over. Steps closer together than the maximum update rate (default 50 Hz) are dropped, and steps that leave the
+// color unchanged send nothing. A pulse goes out to its color and back to the current one once per period; a flash
+// switches between the two; count 0 repeats until another color is set.
+typedef enum
+{
+	GroveLcdRgbBacklight_Ease_Linear,
+	GroveLcdRgbBacklight_Ease_In,
+	GroveLcdRgbBacklight_Ease_Out,
+	GroveLcdRgbBacklight_Ease_InOut
+}
+GroveLcdRgbBacklight_Ease;
+
+void GroveLcdRgbBacklight_FadeTo(void *this, uint8_t red, uint8_t green, uint8_t blue, uint32_t durationMs, GroveLcdRgbBacklight_Ease ease);
+void GroveLcdRgbBacklight_Pulse(void *this, uint8_t red, uint8_t green, uint8_t blue, uint32_t periodMs, int count, GroveLcdRgbBacklight_Ease ease);
+void GroveLcdRgbBacklight_Flash(void *this, uint8_t red, uint8_t green, uint8_t blue, uint32_t onMs, uint32_t offMs, int count);
+void GroveLcdRgbBacklight_SetMaxUpdateRate(void *this, uint32_t hz);
+bool GroveLcdRgbBacklight_Animate(void *this);
+
+// Forget the cached backlight registers and glass contents, e.g. after the display lost power; the next color and
+// the next text update are sent in full.
+void GroveLcdRgbBacklight_InvalidateCache(void *this);
+
+// Custom characters through the eight CGRAM slots. Returns the character code (8..15) showing the 5x8 pattern
+// (one byte per row, low five bits), uploading it only when it is not resident; the least recently used slot that
+// is not in the text shadow is replaced. Returns -1 when every slot is on screen.
+int GroveLcdRgbBacklight_Glyph(void *this, const uint8_t pattern[8]);
+
+// Horizontal bar of width cells for value out of max, five steps per cell, drawn into the text shadow.
+// It needs at most four glyphs, so an animated bar stops uploading once they are resident.
+void GroveLcdRgbBacklight_BarGraph(void *this, int row, int column, int width, int value, int max);
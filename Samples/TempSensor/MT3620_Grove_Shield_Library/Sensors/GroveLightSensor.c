@@ -18,6 +18,7 @@ void* GroveLightSensor_Init(int i2cFd, int analog_pin)
 	GroveLightSensorInstance* this = (GroveLightSensorInstance*)malloc(sizeof(GroveLightSensorInstance));
 	this->inst = GroveAD7992_Open(i2cFd);
 	this->pinId = analog_pin;
+	GroveAD7992_ClaimChannel(this->inst, analog_pin);
 
 	return this;
 }
@@ -28,3 +29,10 @@ float GroveLightSensor_Read(void* inst)
 	return GroveAD7992_Read(this->inst, this->pinId);
 }
 
+void GroveLightSensor_Close(void* inst)
+{
+	GroveLightSensorInstance* this = (GroveLightSensorInstance*)inst;
+	GroveAD7992_ReleaseChannel(this->inst, this->pinId);
+	GroveAD7992_Close(this->inst);
+	free(this);
+}
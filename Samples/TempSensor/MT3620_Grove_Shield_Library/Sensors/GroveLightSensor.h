@@ -5,3 +5,4 @@
 
 void* GroveLightSensor_Init(int i2cFd, int analog_pin);
 float GroveLightSensor_Read(void* inst);
+void GroveLightSensor_Close(void* inst);
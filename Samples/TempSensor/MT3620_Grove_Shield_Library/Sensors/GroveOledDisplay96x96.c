@@ -6,6 +6,7 @@ Grove OLED Display 96x96 v2.0
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 
 #include "GroveOledDisplay96x96.h"
@@ -14,9 +15,6 @@ Grove OLED Display 96x96 v2.0
 
 
 
-#define SH1107G  1
-#define SSD1327  2
-
 #define VERTICAL_MODE                       01
 #define HORIZONTAL_MODE                     02
 
@@ -26,6 +24,7 @@ Grove OLED Display 96x96 v2.0
 /*Command and register */
 #define SeeedGrayOLED_Command_Mode          0x80
 #define SeeedGrayOLED_Data_Mode				 0x40
+#define SeeedGrayOLED_Bulk_Max              254     // data bytes after the control byte in one 255 byte bridge frame
 
 #define SeeedGrayOLED_Display_Off_Cmd       0xAE
 #define SeeedGrayOLED_Display_On_Cmd        0xAF
@@ -36,23 +35,86 @@ Grove OLED Display 96x96 v2.0
 #define SeeedGrayOLED_Dectivate_Scroll_Cmd  0x2E
 #define SeeedGrayOLED_Set_ContrastLevel_Cmd 0x81
 
-#define Scroll_Left             0x00
-#define Scroll_Right            0x01
+/*Panel geometry */
+#define SSD1327_Width           96
+#define SSD1327_Height          96
+#define SSD1327_Column_Offset   0x08        // the 96 pixels start at RAM column 8, two pixels per column
+#define SSD1327_Ram_Columns     64          // the scroll window may include the hidden columns on both sides
+#define SSD1327_Frame_Us        10000       // nominal frame period with the init clock settings, varies per panel
+#define SH1107G_Width           128
+#define SH1107G_Pages           16          // 8 pixel rows per page
+
+// SSD1327 glyphs in GDDRAM order for the vertical text window (4 columns of 8 rows, two pixels per byte),
+// rebuilt whenever the gray level changes. SH1107G glyphs are BasicFont columns as they are.
+#define Glyph_Count             96
+#define SSD1327_Glyph_Bytes     32
+
+// Ticker band: one text line, uploaded from the left panel edge through the hidden columns on the right.
+// Scrolling left for Ticker_Margin_Steps columns exposes exactly the hidden part, so that is one segment.
+#define Ticker_Rows             8
+#define Ticker_Columns          (SSD1327_Ram_Columns - SSD1327_Column_Offset)
+#define Ticker_Margin_Steps     (Ticker_Columns - SSD1327_Width / 2)
+
+typedef struct
+{
+	int I2cFd;
+	uint8_t DriveIC;
+	char AddressingMode;
+	uint8_t GrayH;
+	uint8_t GrayL;
+
+	// Framebuffer: SSD1327 rows of 48 bytes with the left pixel in the high nibble, SH1107G pages of 128 column bytes.
+	// Each row/page keeps the span of bytes changed since the last flush (DirtyLo > DirtyHi when clean).
+	uint8_t *FrameBuffer;
+	uint8_t *FlushBuffer;
+	int FbLineBytes;
+	int FbLines;
+	uint8_t FbDirtyLo[SSD1327_Height];
+	uint8_t FbDirtyHi[SSD1327_Height];
+
+	uint8_t GlyphTable[Glyph_Count][SSD1327_Glyph_Bytes];
 
-#define Scroll_2Frames          0x7
-#define Scroll_3Frames          0x4
-#define Scroll_4Frames          0x5
-#define Scroll_5Frames          0x0
-#define Scroll_25Frames         0x6
-#define Scroll_64Frames         0x1
-#define Scroll_128Frames        0x2
-#define Scroll_256Frames        0x3
+	// Text pointer as the text writes leave it. SSD1327: framebuffer column byte and row inside the window from
+	// TextColumnLo to the right edge over the 8 rows from TextRowLo. SH1107G: column and page. The panel's pointer
+	// is only there while TextWindowSet; everything else that moves it clears the flag.
+	int TextColumnLo;
+	int TextRowLo;
+	int TextColumn;
+	int TextRow;
+	bool TextWindowSet;
+
+	// Hardware-scrolled ticker (SSD1327): the message as Ticker_Rows rows of 4bpp pixels and the message pixel
+	// at the left panel edge when the current segment started scrolling. NULL strip when no ticker runs.
+	uint8_t *TickerStrip;
+	int TickerStripWidth;
+	int TickerY;
+	int TickerOffset;
+	uint8_t TickerSpeed;
+	uint32_t TickerStepUs;
+	uint64_t TickerScrollStartUs;
+	uint64_t TickerStartUs;
+	uint64_t TickerStopUs;
+	GroveOledDisplayTickerStats TickerStats;
+}
+GroveOledDisplayInstance;
+
+// Byte with its bit order reversed: MSB-first bitmap rows to the SH1107G's top-is-bit-0 column bytes
+#define R2(n)   n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define R4(n)   R2(n), R2(n + 2 * 16), R2(n + 1 * 16), R2(n + 3 * 16)
+#define R6(n)   R4(n), R4(n + 2 * 4), R4(n + 1 * 4), R4(n + 3 * 4)
+static const uint8_t BitReverse[256] = { R6(0), R6(2), R6(1), R6(3) };
+
+// 4x4 Bayer matrix for ordered dithering to 16 levels
+static const uint8_t Bayer4[4][4] =
+{
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
 
-static int _i2cFd = -1;
-static int Drive_IC = SH1107G;
-static char addressingMode;
-static uint8_t grayH;
-static uint8_t grayL;
+// Frames per scroll step, indexed by the Scroll_xFrames interval codes
+static const uint16_t ScrollFrames[8] = { 5, 64, 128, 256, 3, 4, 25, 2 };
 
 // This font can be freely used without any restriction(It is placed in public domain)
 const unsigned char BasicFont[][8] =
@@ -155,352 +217,713 @@ const unsigned char BasicFont[][8] =
   {0x00,0x02,0x05,0x05,0x02,0x00,0x00,0x00}
 };
 
-static void sendCommand(uint8_t cmd)
+static void tickerHalt(GroveOledDisplayInstance* this);
+static void tickerScroll(GroveOledDisplayInstance* this, bool scroll);
+
+static void sendCommand(GroveOledDisplayInstance* this, uint8_t cmd)
+{
+	GroveI2C_WriteReg8(this->I2cFd, SeeedGrayOLED_Address, SeeedGrayOLED_Command_Mode, cmd); 	
+}
+
+static void sendData(GroveOledDisplayInstance* this, uint8_t data)
+{
+	GroveI2C_WriteReg8(this->I2cFd, SeeedGrayOLED_Address, SeeedGrayOLED_Data_Mode, data);
+}
+
+// Control byte with Co = 0: every following byte of the transaction is a command
+static void sendCommands(GroveOledDisplayInstance* this, const uint8_t *cmds, int count)
+{
+	static const uint8_t control = 0x00;
+	GroveI2C_WritePrefixed(this->I2cFd, SeeedGrayOLED_Address, &control, 1, cmds, count);
+}
+
+// One data control byte per frame, the rest is GDDRAM
+static void sendDataBulk(GroveOledDisplayInstance* this, const uint8_t *data, int count)
+{
+	static const uint8_t control = SeeedGrayOLED_Data_Mode;
+	GroveI2C_WritePrefixed(this->I2cFd, SeeedGrayOLED_Address, &control, 1, data, count);
+}
+
+static void fbMarkClean(GroveOledDisplayInstance* this)
 {
-	GroveI2C_WriteReg8(_i2cFd, SeeedGrayOLED_Address, SeeedGrayOLED_Command_Mode, cmd); 	
+	memset(this->FbDirtyLo, 0xFF, sizeof(this->FbDirtyLo));
+	memset(this->FbDirtyHi, 0x00, sizeof(this->FbDirtyHi));
 }
 
-static void sendData(uint8_t data)
+// The panel bytes lo..hi of a line were just rewritten from the framebuffer contents, so pending changes there
+// are superseded: the dirty span is cleared when it lies inside, or trimmed when one end does
+static void fbSupersede(GroveOledDisplayInstance* this, int line, int lo, int hi)
 {
-	GroveI2C_WriteReg8(_i2cFd, SeeedGrayOLED_Address, SeeedGrayOLED_Data_Mode, data);
+	if (this->FbDirtyLo[line] >= lo && this->FbDirtyHi[line] <= hi)
+	{
+		this->FbDirtyLo[line] = 0xFF;
+		this->FbDirtyHi[line] = 0x00;
+	}
+	else if (this->FbDirtyLo[line] >= lo && this->FbDirtyLo[line] <= hi)
+	{
+		this->FbDirtyLo[line] = (uint8_t)(hi + 1);
+	}
+	else if (this->FbDirtyHi[line] >= lo && this->FbDirtyHi[line] <= hi)
+	{
+		this->FbDirtyHi[line] = (uint8_t)(lo - 1);
+	}
 }
 
-void GroveOledDisplay_Init(int i2cFd, uint8_t IC)
+static void fbInit(GroveOledDisplayInstance* this)
 {
-	_i2cFd = i2cFd;
-	Drive_IC = IC;
+	free(this->FrameBuffer);
+
+	if (this->DriveIC == SSD1327)
+	{
+		this->FbLineBytes = SSD1327_Width / 2;
+		this->FbLines = SSD1327_Height;
+	}
+	else
+	{
+		this->FbLineBytes = SH1107G_Width;
+		this->FbLines = SH1107G_Pages;
+	}
+
+	this->FrameBuffer = (uint8_t *)calloc(2, (size_t)(this->FbLineBytes * this->FbLines));
+	this->FlushBuffer = this->FrameBuffer != NULL ? this->FrameBuffer + this->FbLineBytes * this->FbLines : NULL;
+
+	// The panel contents are unknown, so the first flush uploads everything
+	memset(this->FbDirtyLo, 0, sizeof(this->FbDirtyLo));
+	memset(this->FbDirtyHi, (uint8_t)(this->FbLineBytes - 1), sizeof(this->FbDirtyHi));
+}
+
+static void buildGlyphTable(GroveOledDisplayInstance* this)
+{
+	for (int c = 0; c < Glyph_Count; c++)
+	{
+		uint8_t *glyph = this->GlyphTable[c];
+		for (int i = 0; i < 8; i = i + 2)
+		{
+			for (int j = 0; j < 8; j++)
+			{
+				uint8_t bit1 = (BasicFont[c][i] >> j) & 0x01;
+				uint8_t bit2 = (BasicFont[c][i + 1] >> j) & 0x01;
+				*glyph++ = (uint8_t)((bit1 ? this->GrayH : 0x00) | (bit2 ? this->GrayL : 0x00));
+			}
+		}
+	}
+}
+
+static const uint8_t *glyphData(GroveOledDisplayInstance* this, unsigned char C, int *size)
+{
+	if (C < 32 || C > 127) //Ignore non-printable ASCII characters. This can be modified for multilingual font.
+	{
+		C = ' '; //Space
+	}
+
+	if (this->DriveIC == SSD1327)
+	{
+		*size = SSD1327_Glyph_Bytes;
+		return this->GlyphTable[C - 32];
+	}
+	*size = 8;
+	return BasicFont[C - 32];
+}
+
+// Puts the panel's GDDRAM pointer back at the text pointer
+static void textWindow(GroveOledDisplayInstance* this)
+{
+	if (this->DriveIC == SSD1327)
+	{
+		// The window restarts at the pointer, so a line that wraps now wraps there
+		this->TextColumnLo = this->TextColumn;
+		this->TextRow = this->TextRowLo;
+		const uint8_t window[] =
+		{
+			0x15, (uint8_t)(SSD1327_Column_Offset + this->TextColumnLo), (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+			0x75, (uint8_t)this->TextRowLo, (uint8_t)(this->TextRowLo + 7)
+		};
+		sendCommands(this, window, sizeof(window));
+	}
+	else
+	{
+		const uint8_t address[] = { (uint8_t)(0xB0 + this->TextRow), (uint8_t)(this->TextColumn & 0x0F), (uint8_t)(0x10 | (this->TextColumn >> 4)) };
+		sendCommands(this, address, sizeof(address));
+	}
+	this->TextWindowSet = true;
+}
+
+// Text data goes out at the text pointer, and every byte is mirrored into the framebuffer where the panel's
+// address increment puts it, so the framebuffer still matches the panel outside the dirty spans
+static void textWrite(GroveOledDisplayInstance* this, const uint8_t *data, int count)
+{
+	if (!this->TextWindowSet) textWindow(this);
+	sendDataBulk(this, data, count);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (this->FrameBuffer != NULL)
+		{
+			this->FrameBuffer[this->TextRow * this->FbLineBytes + this->TextColumn] = data[i];
+			fbSupersede(this, this->TextRow, this->TextColumn, this->TextColumn);
+		}
+
+		if (this->DriveIC == SH1107G)
+		{
+			// Page addressing wraps within the page
+			this->TextColumn = (this->TextColumn + 1) % SH1107G_Width;
+		}
+		else if (this->AddressingMode == HORIZONTAL_MODE)
+		{
+			if (++this->TextColumn == SSD1327_Width / 2)
+			{
+				this->TextColumn = this->TextColumnLo;
+				if (++this->TextRow == this->TextRowLo + 8) this->TextRow = this->TextRowLo;
+			}
+		}
+		else if (++this->TextRow == this->TextRowLo + 8)
+		{
+			this->TextRow = this->TextRowLo;
+			if (++this->TextColumn == SSD1327_Width / 2) this->TextColumn = this->TextColumnLo;
+		}
+	}
+}
+
+void* GroveOledDisplay_Open(int i2cFd, uint8_t IC)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)malloc(sizeof(GroveOledDisplayInstance));
+	if (this == NULL) return NULL;
+	memset(this, 0, sizeof(*this));
+
+	this->I2cFd = i2cFd;
+	this->DriveIC = IC;
 
 	static const struct timespec sleepTime = { 0, 100000000 };
 
-	if (Drive_IC == SSD1327)
-	{
-		sendCommand(0xFD); // Unlock OLED driver IC MCU interface from entering command. i.e: Accept commands
-		sendCommand(0x12);
-		sendCommand(0xAE); // Set display off
-		sendCommand(0xA8); // set multiplex ratio
-		sendCommand(0x5F); // 96
-		sendCommand(0xA1); // set display start line
-		sendCommand(0x00);
-		sendCommand(0xA2); // set display offset
-		sendCommand(0x60);
-		sendCommand(0xA0); // set remap
-		sendCommand(0x46);
-		sendCommand(0xAB); // set vdd internal
-		sendCommand(0x01); //
-		sendCommand(0x81); // set contrasr
-		sendCommand(0x53); // 100 nit
-		sendCommand(0xB1); // Set Phase Length
-		sendCommand(0X51); //
-		sendCommand(0xB3); // Set Display Clock Divide Ratio/Oscillator Frequency
-		sendCommand(0x01);
-		sendCommand(0xB9); //
-		sendCommand(0xBC); // set pre_charge voltage/VCOMH
-		sendCommand(0x08); // (0x08);
-		sendCommand(0xBE); // set VCOMH
-		sendCommand(0X07); // (0x07);
-		sendCommand(0xB6); // Set second pre-charge period
-		sendCommand(0x01); //
-		sendCommand(0xD5); // enable second precharge and enternal vsl
-		sendCommand(0X62); // (0x62);
-		sendCommand(0xA4); // Set Normal Display Mode
-		sendCommand(0x2E); // Deactivate Scroll
-		sendCommand(0xAF); // Switch on display
+	if (this->DriveIC == SSD1327)
+	{
+		sendCommand(this, 0xFD); // Unlock OLED driver IC MCU interface from entering command. i.e: Accept commands
+		sendCommand(this, 0x12);
+		sendCommand(this, 0xAE); // Set display off
+		sendCommand(this, 0xA8); // set multiplex ratio
+		sendCommand(this, 0x5F); // 96
+		sendCommand(this, 0xA1); // set display start line
+		sendCommand(this, 0x00);
+		sendCommand(this, 0xA2); // set display offset
+		sendCommand(this, 0x60);
+		sendCommand(this, 0xA0); // set remap
+		sendCommand(this, 0x46);
+		sendCommand(this, 0xAB); // set vdd internal
+		sendCommand(this, 0x01); //
+		sendCommand(this, 0x81); // set contrasr
+		sendCommand(this, 0x53); // 100 nit
+		sendCommand(this, 0xB1); // Set Phase Length
+		sendCommand(this, 0X51); //
+		sendCommand(this, 0xB3); // Set Display Clock Divide Ratio/Oscillator Frequency
+		sendCommand(this, 0x01);
+		sendCommand(this, 0xB9); //
+		sendCommand(this, 0xBC); // set pre_charge voltage/VCOMH
+		sendCommand(this, 0x08); // (0x08);
+		sendCommand(this, 0xBE); // set VCOMH
+		sendCommand(this, 0X07); // (0x07);
+		sendCommand(this, 0xB6); // Set second pre-charge period
+		sendCommand(this, 0x01); //
+		sendCommand(this, 0xD5); // enable second precharge and enternal vsl
+		sendCommand(this, 0X62); // (0x62);
+		sendCommand(this, 0xA4); // Set Normal Display Mode
+		sendCommand(this, 0x2E); // Deactivate Scroll
+		sendCommand(this, 0xAF); // Switch on display
 		nanosleep(&sleepTime, NULL);
 
 		// Row Address
-		sendCommand(0x75);    // Set Row Address 
-		sendCommand(0x00);    // Start 0
-		sendCommand(0x5f);    // End 95 
+		sendCommand(this, 0x75);    // Set Row Address 
+		sendCommand(this, 0x00);    // Start 0
+		sendCommand(this, 0x5f);    // End 95 
 
 
 		// Column Address
-		sendCommand(0x15);    // Set Column Address 
-		sendCommand(0x08);    // Start from 8th Column of driver IC. This is 0th Column for OLED 
-		sendCommand(0x37);    // End at  (8 + 47)th column. Each Column has 2 pixels(segments)
+		sendCommand(this, 0x15);    // Set Column Address 
+		sendCommand(this, 0x08);    // Start from 8th Column of driver IC. This is 0th Column for OLED 
+		sendCommand(this, 0x37);    // End at  (8 + 47)th column. Each Column has 2 pixels(segments)
 
 		// Init gray level for text. Default:Brightest White
-		grayH = 0xF0;
-		grayL = 0x0F;
+		this->GrayH = 0xF0;
+		this->GrayL = 0x0F;
+		buildGlyphTable(this);
+		this->AddressingMode = VERTICAL_MODE;
 	}
-	else if (Drive_IC == SH1107G)
+	else if (this->DriveIC == SH1107G)
 	{
-		sendCommand(0xae);  //Display OFF 
-		sendCommand(0xd5);  // Set Dclk
-		sendCommand(0x50);  // 100Hz
-		sendCommand(0x20);  // Set row address
-		sendCommand(0x81);  // Set contrast control
-		sendCommand(0x80);
-		sendCommand(0xa0);  // Segment remap
-		sendCommand(0xa4);  // Set Entire Display ON 
-		sendCommand(0xa6);  // Normal display
-		sendCommand(0xad);  // Set external VCC
-		sendCommand(0x80);
-		sendCommand(0xc0);  // Set Common scan direction
-		sendCommand(0xd9);  // Set phase leghth
-		sendCommand(0x1f);
-		sendCommand(0xdb);  // Set Vcomh voltage
-		sendCommand(0x27);
-		sendCommand(0xaf);  //Display ON
-		sendCommand(0xb0);
-		sendCommand(0x00);
-		sendCommand(0x11);
+		sendCommand(this, 0xae);  //Display OFF 
+		sendCommand(this, 0xd5);  // Set Dclk
+		sendCommand(this, 0x50);  // 100Hz
+		sendCommand(this, 0x20);  // Set row address
+		sendCommand(this, 0x81);  // Set contrast control
+		sendCommand(this, 0x80);
+		sendCommand(this, 0xa0);  // Segment remap
+		sendCommand(this, 0xa4);  // Set Entire Display ON 
+		sendCommand(this, 0xa6);  // Normal display
+		sendCommand(this, 0xad);  // Set external VCC
+		sendCommand(this, 0x80);
+		sendCommand(this, 0xc0);  // Set Common scan direction
+		sendCommand(this, 0xd9);  // Set phase leghth
+		sendCommand(this, 0x1f);
+		sendCommand(this, 0xdb);  // Set Vcomh voltage
+		sendCommand(this, 0x27);
+		sendCommand(this, 0xaf);  //Display ON
+		sendCommand(this, 0xb0);
+		sendCommand(this, 0x00);
+		sendCommand(this, 0x11);
 	}
+
+	fbInit(this);
+
+	return this;
+}
+
+void GroveOledDisplay_Close(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+	if (this == NULL) return;
+
+	free(this->TickerStrip);
+	free(this->FrameBuffer);
+	free(this);
 }
 
-void setContrastLevel(unsigned char ContrastLevel)
+void GroveOledDisplay_SetContrastLevel(void* inst, unsigned char ContrastLevel)
 {
-	sendCommand(SeeedGrayOLED_Set_ContrastLevel_Cmd);
-	sendCommand(ContrastLevel);
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	sendCommand(this, SeeedGrayOLED_Set_ContrastLevel_Cmd);
+	sendCommand(this, ContrastLevel);
 }
 
-void setHorizontalMode()
+void GroveOledDisplay_SetHorizontalMode(void* inst)
 {
-	if (Drive_IC == SSD1327)
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC == SSD1327)
 	{
-		sendCommand(0xA0); // remap to
-		sendCommand(0x42); // horizontal mode
+		sendCommand(this, 0xA0); // remap to
+		sendCommand(this, 0x42); // horizontal mode
 
 		// Row Address
-		sendCommand(0x75);    // Set Row Address 
-		sendCommand(0x00);    // Start 0
-		sendCommand(0x5f);    // End 95 
+		sendCommand(this, 0x75);    // Set Row Address 
+		sendCommand(this, 0x00);    // Start 0
+		sendCommand(this, 0x5f);    // End 95 
 
 		// Column Address
-		sendCommand(0x15);    // Set Column Address 
-		sendCommand(0x08);    // Start from 8th Column of driver IC. This is 0th Column for OLED 
-		sendCommand(0x37);    // End at  (8 + 47)th column. Each Column has 2 pixels(or segments)
+		sendCommand(this, 0x15);    // Set Column Address 
+		sendCommand(this, 0x08);    // Start from 8th Column of driver IC. This is 0th Column for OLED 
+		sendCommand(this, 0x37);    // End at  (8 + 47)th column. Each Column has 2 pixels(or segments)
+		this->TextWindowSet = false;
 	}
-	else if (Drive_IC == SH1107G)
+	else if (this->DriveIC == SH1107G)
 	{
-		sendCommand(0xA0);
-		sendCommand(0xC8);
+		sendCommand(this, 0xA0);
+		sendCommand(this, 0xC8);
 	}
+	this->AddressingMode = HORIZONTAL_MODE;
 }
 
-void setVerticalMode()
+void GroveOledDisplay_SetVerticalMode(void* inst)
 {
-	if (Drive_IC == SSD1327)
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC == SSD1327)
 	{
-		sendCommand(0xA0); // remap to
-		sendCommand(0x46); // Vertical mode
+		sendCommand(this, 0xA0); // remap to
+		sendCommand(this, 0x46); // Vertical mode
 	}
-	else if (Drive_IC == SH1107G)
+	else if (this->DriveIC == SH1107G)
 	{
-		sendCommand(0xA0);
-		sendCommand(0xC0);
+		sendCommand(this, 0xA0);
+		sendCommand(this, 0xC0);
 	}
+	this->AddressingMode = VERTICAL_MODE;
 }
 
-void setTextXY(unsigned char Row, unsigned char Column)
+void GroveOledDisplay_SetTextXY(void* inst, unsigned char Row, unsigned char Column)
 {
-	if (Drive_IC == SSD1327)
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC == SSD1327)
 	{
-		//Column Address
-		sendCommand(0x15);             /* Set Column Address */
-		sendCommand((uint8_t)(0x08 + (Column * 4)));  /* Start Column: Start from 8 */
-		sendCommand(0x37);             /* End Column */
-		// Row Address
-		sendCommand(0x75);             /* Set Row Address */
-		sendCommand((uint8_t)(0x00 + (Row * 8)));     /* Start Row*/
-		sendCommand((uint8_t)(0x07 + (Row * 8)));     /* End Row*/
+		if (Row >= SSD1327_Height / 8 || Column >= SSD1327_Width / 8) return;
+
+		// Column window from the text column to the right edge, row window of one text line
+		this->TextColumn = Column * 4;
+		this->TextRowLo = Row * 8;
 	}
-	else if (Drive_IC == SH1107G)
+	else if (this->DriveIC == SH1107G)
 	{
-		uint8_t col_l;
+		if (Row >= SH1107G_Pages || Column >= SH1107G_Width / 8) return;
 
-		if (Column % 2 == 0)
-		{
-			col_l = 0x00;
-		}
-		else
-		{
-			col_l = 0x08;
-		}			 
-		sendCommand((uint8_t)(0xb0 + Row));
-		sendCommand(col_l);
-		sendCommand((uint8_t)(0x10 + (Column / 2)));
+		this->TextColumn = Column * 8;
+		this->TextRow = Row;
 	}
+	textWindow(this);
 }
 
-void clearDisplay()
+void GroveOledDisplay_FillDisplay(void* inst, unsigned char grayLevel)
 {
-	unsigned char i, j;
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	uint8_t pattern;
+	uint8_t chunk[SeeedGrayOLED_Bulk_Max];
 
-	if (Drive_IC == SSD1327)
+	// GDDRAM must not be written while the panel scrolls
+	if (this->TickerStrip != NULL) tickerHalt(this);
+
+	if (this->DriveIC == SSD1327)
 	{
-		for (j = 0; j < 48; j++)
+		pattern = (uint8_t)((grayLevel << 4) | (grayLevel & 0x0F));
+		memset(chunk, pattern, sizeof(chunk));
+
+		// Whole panel window; a filled window looks the same in either addressing mode
+		const uint8_t window[] =
 		{
-			for (i = 0; i < 96; i++)  //clear all columns
-			{
-				sendData(0x00);
-			}
+			0x15, SSD1327_Column_Offset, (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+			0x75, 0x00, SSD1327_Height - 1
+		};
+		sendCommands(this, window, sizeof(window));
+
+		for (int remaining = SSD1327_Width / 2 * SSD1327_Height; remaining > 0; remaining -= SeeedGrayOLED_Bulk_Max)
+		{
+			sendDataBulk(this, chunk, remaining < SeeedGrayOLED_Bulk_Max ? remaining : SeeedGrayOLED_Bulk_Max);
 		}
 	}
-	else if (Drive_IC == SH1107G)
+	else
 	{
-		for (i = 0; i < 16; i++) {
-			sendCommand((uint8_t)(0xb0 + i));
-			sendCommand(0x0);
-			sendCommand(0x10);
-			for (j = 0; j < 128; j++) {
-				sendData(0x00);
-			}
+		pattern = grayLevel ? 0xFF : 0x00;
+		memset(chunk, pattern, sizeof(chunk));
+
+		// Page addressing does not advance to the next page, so each page is addressed on its own
+		for (int page = 0; page < SH1107G_Pages; page++)
+		{
+			const uint8_t address[] = { (uint8_t)(0xB0 + page), 0x00, 0x10 };
+			sendCommands(this, address, sizeof(address));
+			sendDataBulk(this, chunk, SH1107G_Width);
 		}
 	}
+
+	// The panel now matches a uniformly filled framebuffer
+	if (this->FrameBuffer != NULL)
+	{
+		memset(this->FrameBuffer, pattern, (size_t)(this->FbLineBytes * this->FbLines));
+		fbMarkClean(this);
+	}
+	this->TextWindowSet = false;
+
+	// The ticker owns its band: put the text back over the fill, on the panel and in the framebuffer
+	if (this->TickerStrip != NULL) tickerScroll(this, true);
 }
 
-void setGrayLevel(unsigned char grayLevel)
+void GroveOledDisplay_ClearDisplay(void* inst)
 {
-	grayH = (uint8_t)((grayLevel << 4) & 0xF0);
-	grayL = (uint8_t)(grayLevel & 0x0F);
+	GroveOledDisplay_FillDisplay(inst, 0);
 }
 
-void putChar(unsigned char C)
+void GroveOledDisplay_SetGrayLevel(void* inst, unsigned char grayLevel)
 {
-	if (C < 32 || C > 127) //Ignore non-printable ASCII characters. This can be modified for multilingual font.
-	{
-		C = ' '; //Space
-	}
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
 
-	if (Drive_IC == SSD1327)
-	{
-		for (int i = 0; i < 8; i = i + 2)
-		{
-			for (int j = 0; j < 8; j++)
-			{
-				// Character is constructed two pixel at a time using vertical mode from the default 8x8 font
-				char c = 0x00;
-				char bit1 = (BasicFont[C - 32][i] >> j) & 0x01;
-				char bit2 = (BasicFont[C - 32][i + 1] >> j) & 0x01;
-				// Each bit is changed to a nibble
-				c |= (bit1 == 1) ? grayH : 0x00;
-				c |= (bit2 == 1) ? grayL : 0x00;
+	uint8_t h = (uint8_t)((grayLevel << 4) & 0xF0);
+	uint8_t l = (uint8_t)(grayLevel & 0x0F);
+	if (h == this->GrayH && l == this->GrayL) return;
 
-				sendData(c);
-			}
-		}
-	}
-	else if (Drive_IC == SH1107G)
+	this->GrayH = h;
+	this->GrayL = l;
+	if (this->DriveIC == SSD1327)
 	{
-		for (int i = 0; i < 8; i++)
-		{
-			//read bytes from code memory
-			sendData((BasicFont[C - 32][i])); //font array starts at 0, ASCII starts at 32. Hence the translation
-		}
+		buildGlyphTable(this);
 	}
 }
 
-void putString(const char *String)
+void GroveOledDisplay_PutChar(void* inst, unsigned char C)
 {
-	unsigned char i = 0;
-	while (String[i])
-	{
-		putChar(String[i]);
-		i++;
-	}
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	// GDDRAM must not be written while the panel scrolls; text sends its window again after the pause
+	if (this->TickerStrip != NULL) tickerHalt(this);
+
+	int size;
+	const uint8_t *glyph = glyphData(this, C, &size);
+	textWrite(this, glyph, size);
+
+	if (this->TickerStrip != NULL) tickerScroll(this, true);
 }
 
-unsigned char putNumber(long long_num)
+void GroveOledDisplay_PutString(void* inst, const char *String)
 {
-	unsigned char char_buffer[10] = "";
-	unsigned char i = 0;
-	unsigned char f = 0;
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
 
-	if (long_num < 0)
-	{
-		f = 1;
-		putChar('-');
-		long_num = -long_num;
-	}
-	else if (long_num == 0)
+	if (this->TickerStrip != NULL) tickerHalt(this);
+
+	// Glyphs are packed back to back into full bridge frames; GDDRAM addressing doesn't care where a frame ends
+	uint8_t frame[SeeedGrayOLED_Bulk_Max];
+	int fill = 0;
+
+	for (; *String; String++)
 	{
-		f = 1;
-		putChar('0');
-		return f;
+		int size;
+		const uint8_t *glyph = glyphData(this, (unsigned char)*String, &size);
+		while (size > 0)
+		{
+			int n = size < SeeedGrayOLED_Bulk_Max - fill ? size : SeeedGrayOLED_Bulk_Max - fill;
+			memcpy(&frame[fill], glyph, (size_t)n);
+			fill += n;
+			glyph += n;
+			size -= n;
+			if (fill == SeeedGrayOLED_Bulk_Max)
+			{
+				textWrite(this, frame, fill);
+				fill = 0;
+			}
+		}
 	}
 
-	while (long_num > 0)
+	if (fill > 0)
 	{
-		char_buffer[i++] = long_num % 10;
-		long_num /= 10;
+		textWrite(this, frame, fill);
 	}
 
-	f = f + i;
-	for (; i > 0; i--)
+	if (this->TickerStrip != NULL) tickerScroll(this, true);
+}
+
+unsigned char GroveOledDisplay_PutNumber(void* inst, long long_num)
+{
+	char char_buffer[24];
+	unsigned char i = sizeof(char_buffer) - 1;
+	unsigned long n = long_num < 0 ? 0UL - (unsigned long)long_num : (unsigned long)long_num;
+
+	char_buffer[i] = '\0';
+	do
+	{
+		char_buffer[--i] = (char)('0' + n % 10);
+		n /= 10;
+	} while (n > 0 && i > 1);
+	if (long_num < 0)
 	{
-		putChar('0' + char_buffer[i - 1]);
+		char_buffer[--i] = '-';
 	}
-	return f;
 
+	GroveOledDisplay_PutString(inst, &char_buffer[i]);
+	return (unsigned char)(sizeof(char_buffer) - 1 - i);
 }
 
-void drawBitmap(const unsigned char *bitmaparray, int bytes)
+void GroveOledDisplay_DrawBitmap(void* inst, const unsigned char *bitmaparray, int bytes)
 {
-	if (Drive_IC == SSD1327)
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	// GDDRAM must not be written while the panel scrolls
+	if (this->TickerStrip != NULL) tickerHalt(this);
+
+	if (this->DriveIC == SSD1327)
 	{
-		char localAddressMode = addressingMode;
-		if (addressingMode != HORIZONTAL_MODE)
+		// One bit per pixel, rows of 12 bytes from the top left corner. Each byte expands to the 4 GDDRAM bytes
+		// of its 8 pixels, and the expanded bytes are packed into full bridge frames like text.
+		uint8_t frame[SeeedGrayOLED_Bulk_Max];
+		int fill = 0;
+		int sent = 0;
+		if (bytes > SSD1327_Width / 8 * SSD1327_Height) bytes = SSD1327_Width / 8 * SSD1327_Height;
+
+		// Bitmap is drawn in horizontal mode over the whole panel
+		const uint8_t window[] =
 		{
-			//Bitmap is drawn in horizontal mode
-			setHorizontalMode();
-		}
+			0xA0, 0x42,
+			0x15, SSD1327_Column_Offset, (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+			0x75, 0x00, SSD1327_Height - 1
+		};
+		sendCommands(this, window, sizeof(window));
 
 		for (int i = 0; i < bytes; i++)
 		{
-
 			for (int j = 0; j < 8; j = j + 2)
 			{
-				char c = 0x00;
-				char bit1 = (uint8_t)(bitmaparray[i] << j & 0x80);
-				char bit2 = (uint8_t)(bitmaparray[i] << (j + 1) & 0x80);
-
-				// Each bit is changed to a nibble
-				c |= (bit1) ? grayH : 0x00;
 				// Each bit is changed to a nibble
-				c |= (bit2) ? grayL : 0x00;
-				sendData(c);
+				uint8_t c = 0x00;
+				c |= (bitmaparray[i] << j & 0x80) ? this->GrayH : 0x00;
+				c |= (bitmaparray[i] << (j + 1) & 0x80) ? this->GrayL : 0x00;
+				frame[fill++] = c;
+			}
+			if (fill > SeeedGrayOLED_Bulk_Max - 4 || i == bytes - 1)
+			{
+				sendDataBulk(this, frame, fill);
+
+				// Horizontal addressing from the top left walks the panel in framebuffer order
+				if (this->FrameBuffer != NULL) memcpy(&this->FrameBuffer[sent], frame, (size_t)fill);
+				sent += fill;
+				fill = 0;
 			}
 		}
-		if (localAddressMode == VERTICAL_MODE)
+
+		// Keep the framebuffer in step with the panel; pending changes in the rows drawn are superseded
+		if (this->FrameBuffer != NULL)
 		{
-			//If Vertical Mode was used earlier, restore it.
-			setVerticalMode();
+			for (int line = 0; line * this->FbLineBytes < sent; line++)
+			{
+				int end = sent - line * this->FbLineBytes;
+				fbSupersede(this, line, 0, (end < this->FbLineBytes ? end : this->FbLineBytes) - 1);
+			}
+		}
+
+		// If Vertical Mode was used earlier, restore it
+		if (this->AddressingMode == VERTICAL_MODE)
+		{
+			const uint8_t restore[] = { 0xA0, 0x46 };
+			sendCommands(this, restore, sizeof(restore));
+		}
+		else
+		{
+			this->AddressingMode = HORIZONTAL_MODE;
 		}
 	}
-	else if (Drive_IC == SH1107G)
+	else if (this->DriveIC == SH1107G)
 	{
-		uint8_t Row = 0, column_l = 0x00, column_h = 0x10;
+		// The bitmap runs down the 16 pages of a column before moving to the next column, so each page takes
+		// every 16th byte. A page is gathered through the bit reversal table and streamed after one address setup.
+		uint8_t line[SH1107G_Width];
+		if (bytes > SH1107G_Width * SH1107G_Pages) bytes = SH1107G_Width * SH1107G_Pages;
 
-		setHorizontalMode();
-		for (int i = 0; i < bytes; i++)
+		GroveOledDisplay_SetHorizontalMode(this);
+		for (int page = 0; page < SH1107G_Pages && page < bytes; page++)
 		{
-			sendCommand((uint8_t)(0xb0 + Row));
-			sendCommand(column_l);
-			sendCommand(column_h);
+			int columns = bytes / SH1107G_Pages + (page < bytes % SH1107G_Pages ? 1 : 0);
+			for (int column = 0; column < columns; column++)
+			{
+				line[column] = BitReverse[bitmaparray[column * SH1107G_Pages + page]];
+			}
+
+			const uint8_t address[] = { (uint8_t)(0xb0 + page), 0x00, 0x10 };
+			sendCommands(this, address, sizeof(address));
+			sendDataBulk(this, line, columns);
 
-			char bits = (char)bitmaparray[i];
-			char tmp = 0x00;
-			for (int b = 0; b < 8; b++)
+			// Keep the framebuffer in step with the panel
+			if (this->FrameBuffer != NULL)
 			{
-				tmp |= ((bits >> (7 - b)) & 0x01) << b;
+				memcpy(&this->FrameBuffer[page * this->FbLineBytes], line, (size_t)columns);
+				fbSupersede(this, page, 0, columns - 1);
 			}
-			sendData(tmp);
-			// delay(10);
-			Row++;
-			if (Row >= 16) {
-				Row = 0;
-				column_l++;
-				if (column_l >= 16) {
-					column_l = 0x00;
-					column_h += 0x01;
-				}
+		}
+	}
+	this->TextWindowSet = false;
+
+	// Resuming redraws the band, so a bitmap overlapping it is covered by the ticker again
+	if (this->TickerStrip != NULL) tickerScroll(this, true);
+}
+
+int GroveOledDisplay_PackGray(const uint8_t *gray, int width, int height, int stride, GroveOledDisplay_Dither dither, uint8_t *packed)
+{
+	if (width <= 0 || height <= 0) return 0;
+
+	// Floyd-Steinberg carries the error of the current row and the next one, with a guard entry on both ends
+	int16_t *errors = NULL;
+	if (dither == GroveOledDisplay_Dither_FloydSteinberg)
+	{
+		errors = (int16_t *)calloc(2, sizeof(int16_t) * (size_t)(width + 2));
+		if (errors == NULL) return 0;
+	}
+
+	uint8_t *out = packed;
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t *in = &gray[y * stride];
+		int16_t *current = errors != NULL ? &errors[(y & 1) * (width + 2) + 1] : NULL;
+		int16_t *next = errors != NULL ? &errors[((y + 1) & 1) * (width + 2) + 1] : NULL;
+		if (next != NULL) memset(next - 1, 0, sizeof(int16_t) * (size_t)(width + 2));
+
+		for (int x = 0; x < width; x++)
+		{
+			int level;
+			if (dither == GroveOledDisplay_Dither_Ordered)
+			{
+				level = (in[x] * 15 + (Bayer4[y & 3][x & 3] * 255 + 127) / 16) / 255;
+			}
+			else if (current != NULL)
+			{
+				int value = in[x] + current[x] / 16;
+				level = value <= 0 ? 0 : value >= 255 ? 15 : (value * 15 + 127) / 255;
+
+				// Error in 1/16ths: 7 right, 3 down left, 5 down, 1 down right
+				int error = value - level * 17;
+				current[x + 1] = (int16_t)(current[x + 1] + error * 7);
+				next[x - 1] = (int16_t)(next[x - 1] + error * 3);
+				next[x] = (int16_t)(next[x] + error * 5);
+				next[x + 1] = (int16_t)(next[x + 1] + error);
+			}
+			else
+			{
+				level = (in[x] * 15 + 127) / 255;
+			}
+			if (level > 15) level = 15;
+
+			// Left pixel in the high nibble; an odd width leaves the last low nibble black
+			if ((x & 1) == 0)
+			{
+				*out = (uint8_t)(level << 4);
+			}
+			else
+			{
+				*out++ |= (uint8_t)level;
 			}
 		}
+		if (width & 1) out++;
 	}
+
+	free(errors);
+	return (int)(out - packed);
 }
 
-void setHorizontalScrollProperties(bool direction, unsigned char startRow, unsigned char endRow, unsigned char startColumn, unsigned char endColumn, unsigned char scrollSpeed)
+int GroveOledDisplay_DrawImage(void* inst, int x, int y, int width, int height, const uint8_t *packed)
 {
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC != SSD1327) return 0;
+	if (x < 0 || y < 0 || (x & 1) || width <= 0 || height <= 0 || x + width > SSD1327_Width || y + height > SSD1327_Height) return 0;
+
+	// Packed rows are exactly the window, so the whole image is one data transfer
+	int lo = x / 2;
+	int bytesPerRow = (width + 1) / 2;
+	int hi = lo + bytesPerRow - 1;
+
+	if (this->TickerStrip != NULL) tickerHalt(this);
+
+	const uint8_t window[] =
+	{
+		0xA0, 0x42,
+		0x15, (uint8_t)(SSD1327_Column_Offset + lo), (uint8_t)(SSD1327_Column_Offset + hi),
+		0x75, (uint8_t)y, (uint8_t)(y + height - 1)
+	};
+	sendCommands(this, window, sizeof(window));
+	sendDataBulk(this, packed, bytesPerRow * height);
+
+	const uint8_t restore[] =
+	{
+		0xA0, (uint8_t)(this->AddressingMode == HORIZONTAL_MODE ? 0x42 : 0x46),
+		0x15, SSD1327_Column_Offset, (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+		0x75, 0x00, SSD1327_Height - 1
+	};
+	sendCommands(this, restore, sizeof(restore));
+
+	// Keep the framebuffer in step with the panel; pending changes inside the image are superseded
+	if (this->FrameBuffer != NULL)
+	{
+		for (int r = 0; r < height; r++)
+		{
+			int line = y + r;
+			memcpy(&this->FrameBuffer[line * this->FbLineBytes + lo], &packed[r * bytesPerRow], (size_t)bytesPerRow);
+			fbSupersede(this, line, lo, hi);
+		}
+	}
+	this->TextWindowSet = false;
+
+	// Resuming redraws the band, so an image overlapping it is covered by the ticker again
+	if (this->TickerStrip != NULL) tickerScroll(this, true);
+
+	return bytesPerRow * height;
+}
+
+void GroveOledDisplay_SetHorizontalScrollProperties(void* inst, bool direction, unsigned char startRow, unsigned char endRow, unsigned char startColumn, unsigned char endColumn, unsigned char scrollSpeed)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
 	/*
 Use the following defines for 'direction' :
 
@@ -523,39 +946,427 @@ Use the following defines for 'scrollSpeed' :
 	if (Scroll_Right == direction)
 	{
 		//Scroll Right
-		sendCommand(0x27);
+		sendCommand(this, 0x27);
 	}
 	else
 	{
 		//Scroll Left  
-		sendCommand(0x26);
+		sendCommand(this, 0x26);
+	}
+	sendCommand(this, 0x00);       //Dummmy byte
+	sendCommand(this, startRow);
+	sendCommand(this, scrollSpeed);
+	sendCommand(this, endRow);
+	sendCommand(this, (uint8_t)(startColumn + 8));
+	sendCommand(this, (uint8_t)(endColumn + 8));
+	sendCommand(this, 0x00);      //Dummmy byte
+
+}
+
+void GroveOledDisplay_ActivateScroll(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	sendCommand(this, SeeedGrayOLED_Activate_Scroll_Cmd);
+}
+
+void GroveOledDisplay_DeactivateScroll(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	sendCommand(this, SeeedGrayOLED_Dectivate_Scroll_Cmd);
+}
+
+void GroveOledDisplay_SetNormalDisplay(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	sendCommand(this, SeeedGrayOLED_Normal_Display_Cmd);
+}
+
+void GroveOledDisplay_SetInverseDisplay(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	sendCommand(this, SeeedGrayOLED_Inverse_Display_Cmd);
+}
+
+static void fbMarkDirty(GroveOledDisplayInstance* this, int line, int lineByte)
+{
+	if (this->FbDirtyLo[line] > this->FbDirtyHi[line])
+	{
+		this->FbDirtyLo[line] = this->FbDirtyHi[line] = (uint8_t)lineByte;
+	}
+	else if (lineByte < this->FbDirtyLo[line])
+	{
+		this->FbDirtyLo[line] = (uint8_t)lineByte;
+	}
+	else if (lineByte > this->FbDirtyHi[line])
+	{
+		this->FbDirtyHi[line] = (uint8_t)lineByte;
+	}
+}
+
+void GroveOledDisplay_FbSetPixel(void* inst, int x, int y, unsigned char grayLevel)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->FrameBuffer == NULL || x < 0 || y < 0) return;
+
+	if (this->DriveIC == SSD1327)
+	{
+		if (x >= SSD1327_Width || y >= SSD1327_Height) return;
+
+		uint8_t *p = &this->FrameBuffer[y * this->FbLineBytes + x / 2];
+		uint8_t value = (x & 1) ? (uint8_t)((*p & 0xF0) | (grayLevel & 0x0F)) : (uint8_t)((*p & 0x0F) | (grayLevel << 4));
+		if (value == *p) return;
+
+		*p = value;
+		fbMarkDirty(this, y, x / 2);
+	}
+	else
+	{
+		if (x >= SH1107G_Width || y >= SH1107G_Pages * 8) return;
+
+		uint8_t *p = &this->FrameBuffer[(y / 8) * this->FbLineBytes + x];
+		uint8_t bit = (uint8_t)(1 << (y % 8));
+		uint8_t value = grayLevel ? (uint8_t)(*p | bit) : (uint8_t)(*p & ~bit);
+		if (value == *p) return;
+
+		*p = value;
+		fbMarkDirty(this, y / 8, x);
+	}
+}
+
+void GroveOledDisplay_FbFillRect(void* inst, int x, int y, int width, int height, unsigned char grayLevel)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	for (int row = y; row < y + height; row++)
+	{
+		for (int column = x; column < x + width; column++)
+		{
+			GroveOledDisplay_FbSetPixel(this, column, row, grayLevel);
+		}
+	}
+}
+
+void GroveOledDisplay_FbClear(void* inst, unsigned char grayLevel)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC == SSD1327)
+	{
+		GroveOledDisplay_FbFillRect(this, 0, 0, SSD1327_Width, SSD1327_Height, grayLevel);
+	}
+	else
+	{
+		GroveOledDisplay_FbFillRect(this, 0, 0, SH1107G_Width, SH1107G_Pages * 8, grayLevel);
+	}
+}
+
+void GroveOledDisplay_FbDrawString(void* inst, int x, int y, const char *String)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	// Text uses the GroveOledDisplay_SetGrayLevel(this) level on a black background
+	unsigned char foreground = this->DriveIC == SSD1327 ? this->GrayL : 1;
+
+	for (; *String; String++, x += 8)
+	{
+		unsigned char C = (unsigned char)*String;
+		if (C < 32 || C > 127)
+		{
+			C = ' ';
+		}
+
+		for (int i = 0; i < 8; i++)
+		{
+			for (int j = 0; j < 8; j++)
+			{
+				GroveOledDisplay_FbSetPixel(this, x + i, y + j, ((BasicFont[C - 32][i] >> j) & 0x01) ? foreground : 0);
+			}
+		}
+	}
+}
+
+static int fbFlushSSD1327(GroveOledDisplayInstance* this)
+{
+	int sent = 0;
+
+	for (int row = 0; row < this->FbLines; row++)
+	{
+		if (this->FbDirtyLo[row] > this->FbDirtyHi[row]) continue;
+
+		// A run of dirty rows becomes one window covering the union of their spans
+		int lastRow = row;
+		int lo = this->FbDirtyLo[row];
+		int hi = this->FbDirtyHi[row];
+		while (lastRow + 1 < this->FbLines && this->FbDirtyLo[lastRow + 1] <= this->FbDirtyHi[lastRow + 1])
+		{
+			lastRow++;
+			if (this->FbDirtyLo[lastRow] < lo) lo = this->FbDirtyLo[lastRow];
+			if (this->FbDirtyHi[lastRow] > hi) hi = this->FbDirtyHi[lastRow];
+		}
+
+		const uint8_t window[] =
+		{
+			0xA0, 0x42,                                                                         // horizontal address increment
+			0x15, (uint8_t)(SSD1327_Column_Offset + lo), (uint8_t)(SSD1327_Column_Offset + hi),
+			0x75, (uint8_t)row, (uint8_t)lastRow
+		};
+		sendCommands(this, window, sizeof(window));
+
+		int width = hi - lo + 1;
+		int rows = lastRow - row + 1;
+		if (width == this->FbLineBytes)
+		{
+			// Full-width rows are already contiguous
+			sendDataBulk(this, &this->FrameBuffer[row * this->FbLineBytes], rows * width);
+		}
+		else
+		{
+			for (int r = 0; r < rows; r++)
+			{
+				memcpy(&this->FlushBuffer[r * width], &this->FrameBuffer[(row + r) * this->FbLineBytes + lo], (size_t)width);
+			}
+			sendDataBulk(this, this->FlushBuffer, rows * width);
+		}
+		sent += rows * width;
+
+		row = lastRow;
+	}
+
+	if (sent > 0)
+	{
+		// Put the addressing mode back; text sends its own window again
+		const uint8_t restore[] =
+		{
+			0xA0, (uint8_t)(this->AddressingMode == HORIZONTAL_MODE ? 0x42 : 0x46),
+			0x15, SSD1327_Column_Offset, (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+			0x75, 0x00, SSD1327_Height - 1
+		};
+		sendCommands(this, restore, sizeof(restore));
+		this->TextWindowSet = false;
+	}
+
+	return sent;
+}
+
+static int fbFlushSH1107G(GroveOledDisplayInstance* this)
+{
+	int sent = 0;
+
+	for (int page = 0; page < this->FbLines; page++)
+	{
+		if (this->FbDirtyLo[page] > this->FbDirtyHi[page]) continue;
+
+		int lo = this->FbDirtyLo[page];
+		int width = this->FbDirtyHi[page] - lo + 1;
+
+		const uint8_t address[] = { (uint8_t)(0xB0 + page), (uint8_t)(lo & 0x0F), (uint8_t)(0x10 | (lo >> 4)) };
+		sendCommands(this, address, sizeof(address));
+		sendDataBulk(this, &this->FrameBuffer[page * this->FbLineBytes + lo], width);
+		sent += width;
+		this->TextWindowSet = false;
+	}
+
+	return sent;
+}
+
+static uint64_t tickerNowUs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+// Bytes on the bus for a prefixed write: one control byte per bridge frame
+static int busBytes(int count)
+{
+	return count + (count + SeeedGrayOLED_Bulk_Max - 1) / SeeedGrayOLED_Bulk_Max;
+}
+
+// Stops the scroll and moves the offset by the steps the panel has made since it started. The controller leaves
+// GDDRAM undefined after 0x2E, so the band must be rewritten (tickerScroll) before the panel is left alone.
+static void tickerHalt(GroveOledDisplayInstance* this)
+{
+	sendCommand(this, SeeedGrayOLED_Dectivate_Scroll_Cmd);
+
+	uint64_t steps = (tickerNowUs() - this->TickerScrollStartUs) / this->TickerStepUs;
+	if (steps > Ticker_Margin_Steps)
+	{
+		// Polled late: the wrapped columns were on screen for a moment, the text continues after the margin
+		steps = Ticker_Margin_Steps;
 	}
-	sendCommand(0x00);       //Dummmy byte
-	sendCommand(startRow);
-	sendCommand(scrollSpeed);
-	sendCommand(endRow);
-	sendCommand((uint8_t)(startColumn + 8));
-	sendCommand((uint8_t)(endColumn + 8));
-	sendCommand(0x00);      //Dummmy byte
+	this->TickerOffset = (int)((this->TickerOffset + 2 * steps) % (uint64_t)this->TickerStripWidth);
 
+	// A software scroll would redraw the band window for every step
+	this->TickerStats.RedrawBytes += steps * (uint64_t)(busBytes(Ticker_Rows * this->FbLineBytes) + 2 * busBytes(8));
+	this->TickerStats.TxBytes += (uint64_t)busBytes(1);
 }
 
-void activateScroll()
+// Uploads the band at the current offset, including the hidden columns the next segment scrolls into view,
+// then restarts the scroll. The visible part is copied into the framebuffer so a flush never resends it.
+static void tickerScroll(GroveOledDisplayInstance* this, bool scroll)
 {
-	sendCommand(SeeedGrayOLED_Activate_Scroll_Cmd);
+	uint8_t *band = this->FlushBuffer;
+	int stripBytes = this->TickerStripWidth / 2;
+
+	for (int r = 0; r < Ticker_Rows; r++)
+	{
+		const uint8_t *strip = &this->TickerStrip[r * stripBytes];
+		for (int c = 0; c < Ticker_Columns; c++)
+		{
+			// Offsets are even, so every RAM column is one whole strip byte
+			*band++ = strip[(this->TickerOffset / 2 + c) % stripBytes];
+		}
+		memcpy(&this->FrameBuffer[(this->TickerY + r) * this->FbLineBytes], band - Ticker_Columns, (size_t)this->FbLineBytes);
+		this->FbDirtyLo[this->TickerY + r] = 0xFF;
+		this->FbDirtyHi[this->TickerY + r] = 0x00;
+	}
+
+	const uint8_t window[] =
+	{
+		0xA0, 0x42,
+		0x15, SSD1327_Column_Offset, SSD1327_Ram_Columns - 1,
+		0x75, (uint8_t)this->TickerY, (uint8_t)(this->TickerY + Ticker_Rows - 1)
+	};
+	sendCommands(this, window, sizeof(window));
+	sendDataBulk(this, this->FlushBuffer, Ticker_Rows * Ticker_Columns);
+
+	const uint8_t restart[] =
+	{
+		0xA0, (uint8_t)(this->AddressingMode == HORIZONTAL_MODE ? 0x42 : 0x46),
+		0x15, SSD1327_Column_Offset, (uint8_t)(SSD1327_Column_Offset + SSD1327_Width / 2 - 1),
+		0x75, 0x00, SSD1327_Height - 1,
+		0x26, 0x00, (uint8_t)this->TickerY, this->TickerSpeed, (uint8_t)(this->TickerY + Ticker_Rows - 1),
+		SSD1327_Column_Offset, SSD1327_Ram_Columns - 1, 0x00,
+		SeeedGrayOLED_Activate_Scroll_Cmd
+	};
+	int restartBytes = scroll ? (int)sizeof(restart) : 8;
+	sendCommands(this, restart, restartBytes);
+	this->TextWindowSet = false;
+
+	this->TickerScrollStartUs = tickerNowUs();
+	this->TickerStats.TxBytes += (uint64_t)(busBytes(sizeof(window)) + busBytes(Ticker_Rows * Ticker_Columns) + busBytes(restartBytes));
+	if (scroll) this->TickerStats.Segments++;
 }
 
-void deactivateScroll()
+int GroveOledDisplay_Flush(void* inst)
 {
-	sendCommand(SeeedGrayOLED_Dectivate_Scroll_Cmd);
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->FrameBuffer == NULL) return 0;
+
+	if (this->TickerStrip != NULL)
+	{
+		// The ticker owns its band, and GDDRAM must not be written while the panel scrolls
+		bool dirty = false;
+		for (int row = 0; row < this->FbLines; row++)
+		{
+			if (row >= this->TickerY && row < this->TickerY + Ticker_Rows) continue;
+			dirty = dirty || this->FbDirtyLo[row] <= this->FbDirtyHi[row];
+		}
+		if (!dirty) return 0;
+
+		tickerHalt(this);
+		for (int r = 0; r < Ticker_Rows; r++)
+		{
+			this->FbDirtyLo[this->TickerY + r] = 0xFF;
+			this->FbDirtyHi[this->TickerY + r] = 0x00;
+		}
+		int sent = fbFlushSSD1327(this);
+		fbMarkClean(this);
+		tickerScroll(this, true);
+		return sent;
+	}
+
+	int sent = this->DriveIC == SSD1327 ? fbFlushSSD1327(this) : fbFlushSH1107G(this);
+	fbMarkClean(this);
+
+	return sent;
 }
 
-void setNormalDisplay()
+bool GroveOledDisplay_TickerStart(void* inst, int y, const char *String, unsigned char scrollSpeed, uint32_t frameUs)
 {
-	sendCommand(SeeedGrayOLED_Normal_Display_Cmd);
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->DriveIC != SSD1327 || this->FrameBuffer == NULL) return false;
+	if (y < 0 || y > SSD1327_Height - Ticker_Rows || scrollSpeed > Scroll_2Frames) return false;
+
+	int length = (int)strlen(String);
+	if (length == 0) return false;
+
+	GroveOledDisplay_TickerStop(this);
+
+	// The message as a strip of 4bpp rows; it repeats, so trailing spaces separate the repetitions
+	this->TickerStrip = (uint8_t *)malloc((size_t)(Ticker_Rows * length * 4));
+	if (this->TickerStrip == NULL) return false;
+	this->TickerStripWidth = length * 8;
+	for (int k = 0; k < length; k++)
+	{
+		int size;
+		const uint8_t *glyph = glyphData(this, (unsigned char)String[k], &size);
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < Ticker_Rows; j++)
+			{
+				this->TickerStrip[j * length * 4 + k * 4 + i] = glyph[i * 8 + j];
+			}
+		}
+	}
+
+	this->TickerY = y;
+	this->TickerOffset = 0;
+	this->TickerSpeed = scrollSpeed;
+	this->TickerStepUs = ScrollFrames[scrollSpeed] * (frameUs != 0 ? frameUs : SSD1327_Frame_Us);
+	memset(&this->TickerStats, 0, sizeof(this->TickerStats));
+	this->TickerStartUs = tickerNowUs();
+	this->TickerStopUs = 0;
+
+	tickerScroll(this, true);
+	return true;
+}
+
+bool GroveOledDisplay_TickerUpdate(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->TickerStrip == NULL) return false;
+	if (tickerNowUs() - this->TickerScrollStartUs < (uint64_t)Ticker_Margin_Steps * this->TickerStepUs) return false;
+
+	tickerHalt(this);
+	tickerScroll(this, true);
+	return true;
+}
+
+void GroveOledDisplay_TickerStop(void* inst)
+{
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	if (this->TickerStrip == NULL) return;
+
+	// Leave the text where the scroll stopped
+	tickerHalt(this);
+	tickerScroll(this, false);
+
+	free(this->TickerStrip);
+	this->TickerStrip = NULL;
+	this->TickerStopUs = tickerNowUs();
 }
 
-void setInverseDisplay()
+void GroveOledDisplay_GetTickerStats(void* inst, GroveOledDisplayTickerStats* stats)
 {
-	sendCommand(SeeedGrayOLED_Inverse_Display_Cmd);
-}
\ No newline at end of file
+	GroveOledDisplayInstance* this = (GroveOledDisplayInstance*)inst;
+
+	*stats = this->TickerStats;
+
+	uint64_t elapsedUs = (this->TickerStopUs != 0 ? this->TickerStopUs : tickerNowUs()) - this->TickerStartUs;
+	stats->ElapsedMs = (uint32_t)(elapsedUs / 1000);
+	if (elapsedUs > 0)
+	{
+		stats->TxBytesPerSecond = (uint32_t)(stats->TxBytes * 1000000 / elapsedUs);
+		stats->RedrawBytesPerSecond = (uint32_t)(stats->RedrawBytes * 1000000 / elapsedUs);
+	}
+}
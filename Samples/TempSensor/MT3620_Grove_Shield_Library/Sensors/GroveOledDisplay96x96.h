@@ -9,25 +9,92 @@
 #define SH1107G  1
 #define SSD1327  2
 
-void GroveOledDisplay_Init(int i2cFd, uint8_t IC);
+#define Scroll_Left             0x00
+#define Scroll_Right            0x01
 
-void setNormalDisplay();
-void setInverseDisplay();
+#define Scroll_2Frames          0x7
+#define Scroll_3Frames          0x4
+#define Scroll_4Frames          0x5
+#define Scroll_5Frames          0x0
+#define Scroll_25Frames         0x6
+#define Scroll_64Frames         0x1
+#define Scroll_128Frames        0x2
+#define Scroll_256Frames        0x3
 
-void setGrayLevel(unsigned char grayLevel);
+typedef struct
+{
+	uint32_t Segments;              // scroll restarts, each rewriting the band once
+	uint64_t TxBytes;               // bus bytes sent by the ticker, commands included
+	uint64_t RedrawBytes;           // bus bytes a software scroll redrawing the band every step would have sent
+	uint32_t ElapsedMs;
+	uint32_t TxBytesPerSecond;
+	uint32_t RedrawBytesPerSecond;
+}
+GroveOledDisplayTickerStats;
 
-void setVerticalMode();
-void setHorizontalMode();
+// Each instance owns its bus handle, text state and framebuffer; use one instance from one thread at a time.
+void* GroveOledDisplay_Open(int i2cFd, uint8_t IC);
+void GroveOledDisplay_Close(void* inst);
 
-void setTextXY(unsigned char Row, unsigned char Column);
-void clearDisplay();
-void setContrastLevel(unsigned char ContrastLevel);
-void putChar(unsigned char c);
-void putString(const char *String);
-unsigned char putNumber(long n);
+void GroveOledDisplay_SetNormalDisplay(void* inst);
+void GroveOledDisplay_SetInverseDisplay(void* inst);
 
-void drawBitmap(const unsigned char *bitmaparray, int bytes);
+void GroveOledDisplay_SetGrayLevel(void* inst, unsigned char grayLevel);
 
-void setHorizontalScrollProperties(bool direction, unsigned char startRow, unsigned char endRow, unsigned char startColumn, unsigned char endColumn, unsigned char scrollSpeed);
-void activateScroll();
-void deactivateScroll();
\ No newline at end of file
+void GroveOledDisplay_SetVerticalMode(void* inst);
+void GroveOledDisplay_SetHorizontalMode(void* inst);
+
+// Text is drawn at a text pointer that SetTextXY places on an 8x8 cell (cells off the panel are ignored) and each
+// character advances, wrapping back within the line; drawing elsewhere in between does not move it.
+void GroveOledDisplay_SetTextXY(void* inst, unsigned char Row, unsigned char Column);
+// Clear and fill stream the whole panel in bulk frames and leave the framebuffer in sync.
+void GroveOledDisplay_ClearDisplay(void* inst);
+void GroveOledDisplay_FillDisplay(void* inst, unsigned char grayLevel);
+void GroveOledDisplay_SetContrastLevel(void* inst, unsigned char ContrastLevel);
+void GroveOledDisplay_PutChar(void* inst, unsigned char c);
+void GroveOledDisplay_PutString(void* inst, const char *String);
+unsigned char GroveOledDisplay_PutNumber(void* inst, long n);
+
+void GroveOledDisplay_DrawBitmap(void* inst, const unsigned char *bitmaparray, int bytes);
+
+// Grayscale images for the SSD1327: 8-bit pixels (stride bytes per row) are quantized to the 16 panel levels and
+// packed two pixels per byte, left pixel in the high nibble, in one pass. Returns the packed size, which is
+// GroveOledDisplay_PackedSize(width, height). Pack static assets once and keep the result (or generate it offline);
+// GroveOledDisplay_DrawImage then uploads it as one window in a single bulk transfer, x must be even.
+#define GroveOledDisplay_PackedSize(width, height)  ((((width) + 1) / 2) * (height))
+
+typedef enum
+{
+	GroveOledDisplay_Dither_None,
+	GroveOledDisplay_Dither_Ordered,            // 4x4 Bayer, stable for animations
+	GroveOledDisplay_Dither_FloydSteinberg      // error diffusion, best for photos and gradients
+}
+GroveOledDisplay_Dither;
+
+int GroveOledDisplay_PackGray(const uint8_t *gray, int width, int height, int stride, GroveOledDisplay_Dither dither, uint8_t *packed);
+int GroveOledDisplay_DrawImage(void* inst, int x, int y, int width, int height, const uint8_t *packed);
+
+void GroveOledDisplay_SetHorizontalScrollProperties(void* inst, bool direction, unsigned char startRow, unsigned char endRow, unsigned char startColumn, unsigned char endColumn, unsigned char scrollSpeed);
+void GroveOledDisplay_ActivateScroll(void* inst);
+void GroveOledDisplay_DeactivateScroll(void* inst);
+
+// RAM framebuffer (4bpp on SSD1327, 1bpp on SH1107G). These only touch memory; GroveOledDisplay_Flush uploads the rows
+// and columns changed since the previous flush through window addressing and returns the number of GDDRAM bytes sent.
+// The direct functions above write the panel at once and copy what they draw into the framebuffer, superseding
+// pending changes underneath, so a later flush never paints stale framebuffer bytes over them.
+void GroveOledDisplay_FbClear(void* inst, unsigned char grayLevel);
+void GroveOledDisplay_FbSetPixel(void* inst, int x, int y, unsigned char grayLevel);
+void GroveOledDisplay_FbFillRect(void* inst, int x, int y, int width, int height, unsigned char grayLevel);
+void GroveOledDisplay_FbDrawString(void* inst, int x, int y, const char *String);
+int GroveOledDisplay_Flush(void* inst);
+
+// Marquee of one 8 pixel text line at row y (SSD1327 only). The panel's horizontal scroll moves the text; the driver
+// only uploads the band again once the 16 pixels staged in the hidden RAM columns have scrolled into view.
+// Call GroveOledDisplay_TickerUpdate at least every scroll step (frames per step x frameUs; 0 selects a nominal
+// frame period, measure it for a particular panel). The ticker owns its band: GroveOledDisplay_Flush and every direct
+// drawing function pause the scroll around their writes and leave the band to the ticker. Each pause re-uploads the
+// band, so while a ticker runs prefer PutString over a PutChar loop.
+bool GroveOledDisplay_TickerStart(void* inst, int y, const char *String, unsigned char scrollSpeed, uint32_t frameUs);
+bool GroveOledDisplay_TickerUpdate(void* inst);
+void GroveOledDisplay_TickerStop(void* inst);
+void GroveOledDisplay_GetTickerStats(void* inst, GroveOledDisplayTickerStats* stats);
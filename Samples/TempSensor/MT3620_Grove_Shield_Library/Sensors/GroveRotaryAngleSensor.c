@@ -16,6 +16,7 @@ void* GroveRotaryAngleSensor_Init(int i2cFd, int analog_pin)
 	GroveRotaryAngleSensorInstance* this = (GroveRotaryAngleSensorInstance*)malloc(sizeof(GroveRotaryAngleSensorInstance));
 	this->inst = GroveAD7992_Open(i2cFd);
 	this->pinId = analog_pin;
+	GroveAD7992_ClaimChannel(this->inst, analog_pin);
 
 	return this;
 }
@@ -26,3 +27,10 @@ float GroveRotaryAngleSensor_Read(void* inst)
 	return GroveAD7992_Read(this->inst, this->pinId);
 }
 
+void GroveRotaryAngleSensor_Close(void* inst)
+{
+	GroveRotaryAngleSensorInstance* this = (GroveRotaryAngleSensorInstance*)inst;
+	GroveAD7992_ReleaseChannel(this->inst, this->pinId);
+	GroveAD7992_Close(this->inst);
+	free(this);
+}
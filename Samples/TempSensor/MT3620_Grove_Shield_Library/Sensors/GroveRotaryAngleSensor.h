@@ -4,4 +4,5 @@
 #pragma once
 
 void* GroveRotaryAngleSensor_Init(int i2cFd, int analog_pin);
-float GroveRotaryAngleSensor_Read(void* inst);
\ No newline at end of file
+float GroveRotaryAngleSensor_Read(void* inst);
+void GroveRotaryAngleSensor_Close(void* inst);
\ No newline at end of file
@@ -1,69 +1,242 @@
 #include "GroveTempHumiBaroBME280.h"
 #include <stdlib.h>
-#include <math.h>
+#include <time.h>
 #include "../HAL/GroveI2C.h"
+#include "GroveBME280Compensation.h"
+
+#ifndef GROVE_BME280_NO_FLOAT
+#include <math.h>
+#endif
 
 #define BME280_ADDRESS				(0x76 << 1)
 
-#define BME280_REG_DIG_T1			(0x88)
-#define BME280_REG_DIG_T2			(0x8A)
-#define BME280_REG_DIG_T3			(0x8C)
+#define BME280_REG_CALIB00			(0x88)	// dig_T1 .. dig_H1, 26 bytes
+#define BME280_REG_CALIB26			(0xE1)	// dig_H2 .. dig_H6, 7 bytes
 #define BME280_REG_CHIPID			(0xD0)
 #define BME280_REG_CONTROLHUMID		(0xF2)
+#define BME280_REG_STATUS			(0xF3)
 #define BME280_REG_CONTROL			(0xF4)
-#define BME280_REG_TEMPDATA			(0xFA)
+#define BME280_REG_CONFIG			(0xF5)
+#define BME280_REG_DATA				(0xF7)	// press, temp, hum: 8 bytes
+
+#define BME280_STATUS_MEASURING		(0x08)
+#define BME280_FORCED_RETRIES		4
+
+#define BME280_DATA_SIZE			8
 
 typedef struct
 {
 	int I2cFd;
-	float Temperature;
+	GroveBME280Calibration Calib;
+	GroveTempHumiBaroBME280Config Config;
+	bool Valid;
+	int32_t Temperature;	// 0.01 degC
+	uint32_t Pressure;		// Pa * 256
+	uint32_t Humidity;		// %RH * 1024
 }
 GroveTempHumiBaroBME280Instance;
 
+static bool read_calibration(GroveTempHumiBaroBME280Instance* this)
+{
+	uint8_t c[GROVE_BME280_CALIB00_SIZE];
+	uint8_t h[GROVE_BME280_CALIB26_SIZE];
+	uint8_t reg;
+
+	reg = BME280_REG_CALIB00;
+	if (!GroveI2C_WriteRead(this->I2cFd, BME280_ADDRESS, &reg, 1, c, sizeof(c))) return false;
+	reg = BME280_REG_CALIB26;
+	if (!GroveI2C_WriteRead(this->I2cFd, BME280_ADDRESS, &reg, 1, h, sizeof(h))) return false;
+
+	GroveBME280Compensation_ParseCalibration(&this->Calib, c, h);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GroveTempHumiBaroBME280
+
 void* GroveTempHumiBaroBME280_Open(int i2cFd)
 {
 	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)malloc(sizeof(GroveTempHumiBaroBME280Instance));
+	if (this == NULL) return NULL;
 
 	this->I2cFd = i2cFd;
-	this->Temperature = NAN;
+	this->Valid = false;
 
+	// Calibration is factory programmed; read it once
 	uint8_t val8;
-	if (!GroveI2C_ReadReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CHIPID, &val8)) return NULL;
-	if (val8 != 0x60) return NULL;
+	if (!GroveI2C_ReadReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CHIPID, &val8) || val8 != 0x60 || !read_calibration(this))
+	{
+		free(this);
+		return NULL;
+	}
 
-	GroveI2C_WriteReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CONTROLHUMID, 0x05);
-	GroveI2C_WriteReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CONTROL, 0xb7);
+	GroveTempHumiBaroBME280Config config;
+	GroveTempHumiBaroBME280_GetDefaultConfig(&config);
+	GroveTempHumiBaroBME280_Configure(this, &config);
 
 	return this;
 }
 
+// Integer kernel only; the float getters convert on demand
+static void compensate(GroveTempHumiBaroBME280Instance* this, const uint8_t* data)
+{
+	GroveBME280Raw raw;
+	GroveBME280Compensation_ParseData(&raw, data);
+
+	int32_t t_fine;
+	this->Temperature = GroveBME280Compensation_TemperatureInt(&this->Calib, raw.Temperature, &t_fine);
+	this->Pressure = GroveBME280Compensation_PressureInt(&this->Calib, raw.Pressure, t_fine);
+	this->Humidity = GroveBME280Compensation_HumidityInt(&this->Calib, raw.Humidity, t_fine);
+	this->Valid = true;
+}
+
 void GroveTempHumiBaroBME280_Read(void* inst)
 {
 	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
 
-	this->Temperature = NAN;
+	this->Valid = false;
+
+	// Pressure, temperature and humidity in one burst so all three come from the same conversion
+	uint8_t reg = BME280_REG_DATA;
+	uint8_t data[BME280_DATA_SIZE];
+	if (!GroveI2C_WriteRead(this->I2cFd, BME280_ADDRESS, &reg, 1, data, sizeof(data))) return;
+
+	compensate(this, data);
+}
+
+void GroveTempHumiBaroBME280_GetDefaultConfig(GroveTempHumiBaroBME280Config* config)
+{
+	config->Mode = GroveTempHumiBaroBME280_Mode_Normal;
+	config->TemperatureOversampling = GroveTempHumiBaroBME280_Oversampling_X16;
+	config->PressureOversampling = GroveTempHumiBaroBME280_Oversampling_X16;
+	config->HumidityOversampling = GroveTempHumiBaroBME280_Oversampling_X16;
+	config->Filter = GroveTempHumiBaroBME280_Filter_Off;
+	config->Standby = GroveTempHumiBaroBME280_Standby_0_5ms;
+}
+
+static uint8_t ctrl_meas(const GroveTempHumiBaroBME280Config* config, GroveTempHumiBaroBME280_Mode mode)
+{
+	return (uint8_t)((config->TemperatureOversampling & 7) << 5 | (config->PressureOversampling & 7) << 2 | (mode & 3));
+}
+
+bool GroveTempHumiBaroBME280_Configure(void* inst, const GroveTempHumiBaroBME280Config* config)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
+
+	if (config->Mode == 2 || config->Mode > GroveTempHumiBaroBME280_Mode_Normal) return false;
+	if (config->TemperatureOversampling > GroveTempHumiBaroBME280_Oversampling_X16 ||
+		config->PressureOversampling > GroveTempHumiBaroBME280_Oversampling_X16 ||
+		config->HumidityOversampling > GroveTempHumiBaroBME280_Oversampling_X16 ||
+		config->Filter > GroveTempHumiBaroBME280_Filter_16 || config->Standby > GroveTempHumiBaroBME280_Standby_20ms) return false;
+
+	this->Config = *config;
+
+	// config is only reliably written in sleep mode, and ctrl_hum only takes effect with the following ctrl_meas write
+	uint8_t send[6] =
+	{
+		BME280_REG_CONTROL, ctrl_meas(config, GroveTempHumiBaroBME280_Mode_Sleep),
+		BME280_REG_CONFIG, (uint8_t)((config->Standby & 7) << 5 | (config->Filter & 7) << 2),
+		BME280_REG_CONTROLHUMID, (uint8_t)(config->HumidityOversampling & 7),
+	};
+	GroveI2C_Write(this->I2cFd, BME280_ADDRESS, send, sizeof(send));
+
+	// Forced mode starts converting on the ctrl_meas write, so it waits for GroveTempHumiBaroBME280_ReadForced
+	if (config->Mode == GroveTempHumiBaroBME280_Mode_Normal)
+	{
+		GroveI2C_WriteReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CONTROL, ctrl_meas(config, config->Mode));
+	}
+
+	return true;
+}
 
-	uint16_t dig_T1;
-	int16_t dig_T2;
-	int16_t dig_T3;
-	if (!GroveI2C_ReadReg16(this->I2cFd, BME280_ADDRESS, BME280_REG_DIG_T1, &dig_T1)) return;
-	if (!GroveI2C_ReadReg16(this->I2cFd, BME280_ADDRESS, BME280_REG_DIG_T2, (uint16_t*)&dig_T2)) return;
-	if (!GroveI2C_ReadReg16(this->I2cFd, BME280_ADDRESS, BME280_REG_DIG_T3, (uint16_t*)&dig_T3)) return;
+uint32_t GroveTempHumiBaroBME280_GetMeasurementTimeUs(void* inst)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
 
-	int32_t adc_T;
-	if (!GroveI2C_ReadReg24BE(this->I2cFd, BME280_ADDRESS, BME280_REG_TEMPDATA, &adc_T)) return;
+	static const uint32_t samples[6] = { 0, 1, 2, 4, 8, 16 };
+	uint32_t t = samples[this->Config.TemperatureOversampling];
+	uint32_t p = samples[this->Config.PressureOversampling];
+	uint32_t h = samples[this->Config.HumidityOversampling];
 
-	adc_T >>= 4;
-	int32_t var1 = (((adc_T >> 3) - ((int32_t)(dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
-	int32_t var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) * ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+	return 1250 + 2300 * t + (p > 0 ? 2300 * p + 575 : 0) + (h > 0 ? 2300 * h + 575 : 0);
+}
+
+bool GroveTempHumiBaroBME280_ReadForced(void* inst)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
 
-	int32_t t_fine = var1 + var2;
-	this->Temperature = (float)((t_fine * 5 + 128) >> 8) / 100;
+	this->Valid = false;
+
+	// ctrl_hum is latched, so re-arming only needs ctrl_meas
+	GroveI2C_WriteReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CONTROL, ctrl_meas(&this->Config, GroveTempHumiBaroBME280_Mode_Forced));
+
+	bool ok = false;
+	uint32_t waitUs = GroveTempHumiBaroBME280_GetMeasurementTimeUs(this);
+	for (int attempt = 0; attempt < BME280_FORCED_RETRIES; attempt++)
+	{
+		const struct timespec t_convert = { 0, (long)waitUs * 1000 };
+		nanosleep(&t_convert, NULL);
+
+		// Status through the data block (0xF3..0xFE) in one burst: a clear measuring bit vouches for the data
+		uint8_t reg = BME280_REG_STATUS;
+		uint8_t block[4 + BME280_DATA_SIZE];
+		if (!GroveI2C_WriteRead(this->I2cFd, BME280_ADDRESS, &reg, 1, block, sizeof(block))) break;
+
+		if ((block[0] & BME280_STATUS_MEASURING) == 0)
+		{
+			compensate(this, &block[4]);
+			ok = true;
+			break;
+		}
+
+		// The datasheet figure is a maximum, but clock tolerance can still leave us short; top up in small steps
+		waitUs = waitUs / 8 + 100;
+	}
+
+	// The chip drops back to sleep after a forced conversion; put a Normal-mode configuration back to converting
+	if (this->Config.Mode == GroveTempHumiBaroBME280_Mode_Normal)
+	{
+		GroveI2C_WriteReg8(this->I2cFd, BME280_ADDRESS, BME280_REG_CONTROL, ctrl_meas(&this->Config, this->Config.Mode));
+	}
+
+	return ok;
 }
 
+bool GroveTempHumiBaroBME280_GetFixed(void* inst, int32_t* centiCelsius, uint32_t* pressureQ24_8, uint32_t* humidityQ22_10)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
+
+	if (!this->Valid) return false;
+
+	if (centiCelsius != NULL) *centiCelsius = this->Temperature;
+	if (pressureQ24_8 != NULL) *pressureQ24_8 = this->Pressure;
+	if (humidityQ22_10 != NULL) *humidityQ22_10 = this->Humidity;
+
+	return true;
+}
+
+#ifndef GROVE_BME280_NO_FLOAT
+
 float GroveTempHumiBaroBME280_GetTemperature(void* inst)
 {
 	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
 
-	return this->Temperature;
+	return this->Valid ? (float)this->Temperature / 100 : NAN;
+}
+
+float GroveTempHumiBaroBME280_GetPressure(void* inst)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
+
+	return this->Valid ? (float)this->Pressure / 256 : NAN;
 }
+
+float GroveTempHumiBaroBME280_GetHumidity(void* inst)
+{
+	GroveTempHumiBaroBME280Instance* this = (GroveTempHumiBaroBME280Instance*)inst;
+
+	return this->Valid ? (float)this->Humidity / 1024 : NAN;
+}
+
+#endif
@@ -3,7 +3,83 @@
 //WIKI_URL          http://wiki.seeedstudio.com/Grove-Barometer_Sensor-BME280/
 
 #pragma once
+#include <stdint.h>
+#include <stdbool.h>
 #include "../applibs_versions.h"
+
+typedef enum
+{
+	GroveTempHumiBaroBME280_Mode_Sleep = 0,
+	GroveTempHumiBaroBME280_Mode_Forced = 1,	// one conversion per GroveTempHumiBaroBME280_ReadForced
+	GroveTempHumiBaroBME280_Mode_Normal = 3		// continuous conversions, Standby apart
+}
+GroveTempHumiBaroBME280_Mode;
+
+typedef enum
+{
+	GroveTempHumiBaroBME280_Oversampling_Skip = 0,	// channel off, reads back 0x80000 / 0x8000
+	GroveTempHumiBaroBME280_Oversampling_X1,
+	GroveTempHumiBaroBME280_Oversampling_X2,
+	GroveTempHumiBaroBME280_Oversampling_X4,
+	GroveTempHumiBaroBME280_Oversampling_X8,
+	GroveTempHumiBaroBME280_Oversampling_X16
+}
+GroveTempHumiBaroBME280_Oversampling;
+
+typedef enum
+{
+	GroveTempHumiBaroBME280_Filter_Off = 0,
+	GroveTempHumiBaroBME280_Filter_2,
+	GroveTempHumiBaroBME280_Filter_4,
+	GroveTempHumiBaroBME280_Filter_8,
+	GroveTempHumiBaroBME280_Filter_16
+}
+GroveTempHumiBaroBME280_Filter;
+
+typedef enum
+{
+	GroveTempHumiBaroBME280_Standby_0_5ms = 0,
+	GroveTempHumiBaroBME280_Standby_62_5ms,
+	GroveTempHumiBaroBME280_Standby_125ms,
+	GroveTempHumiBaroBME280_Standby_250ms,
+	GroveTempHumiBaroBME280_Standby_500ms,
+	GroveTempHumiBaroBME280_Standby_1000ms,
+	GroveTempHumiBaroBME280_Standby_10ms,
+	GroveTempHumiBaroBME280_Standby_20ms
+}
+GroveTempHumiBaroBME280_Standby;
+
+typedef struct
+{
+	GroveTempHumiBaroBME280_Mode Mode;
+	GroveTempHumiBaroBME280_Oversampling TemperatureOversampling;
+	GroveTempHumiBaroBME280_Oversampling PressureOversampling;
+	GroveTempHumiBaroBME280_Oversampling HumidityOversampling;
+	GroveTempHumiBaroBME280_Filter Filter;
+	GroveTempHumiBaroBME280_Standby Standby;	// normal mode only
+}
+GroveTempHumiBaroBME280Config;
+
 void* GroveTempHumiBaroBME280_Open(int i2cFd);
 void GroveTempHumiBaroBME280_Read(void* inst);
-float GroveTempHumiBaroBME280_GetTemperature(void* inst);
+
+// What Open applies: normal mode, x16 oversampling on all channels, no filter, 0.5 ms standby.
+void GroveTempHumiBaroBME280_GetDefaultConfig(GroveTempHumiBaroBME280Config* config);
+bool GroveTempHumiBaroBME280_Configure(void* inst, const GroveTempHumiBaroBME280Config* config);
+
+// Worst case conversion time for the current oversampling (datasheet 9.1).
+uint32_t GroveTempHumiBaroBME280_GetMeasurementTimeUs(void* inst);
+
+// Starts one forced conversion, sleeps for the conversion time and reads the result; works in any configured mode.
+// A Normal-mode configuration is resumed afterwards, so later GroveTempHumiBaroBME280_Read calls keep getting fresh data.
+bool GroveTempHumiBaroBME280_ReadForced(void* inst);
+
+// Last reading in fixed point: 0.01 degC, Pa * 256, %RH * 1024. False if the last read failed. Any pointer may be NULL.
+bool GroveTempHumiBaroBME280_GetFixed(void* inst, int32_t* centiCelsius, uint32_t* pressureQ24_8, uint32_t* humidityQ22_10);
+
+// Float views of the same reading, NAN if the last read failed; not built with GROVE_BME280_NO_FLOAT.
+#ifndef GROVE_BME280_NO_FLOAT
+float GroveTempHumiBaroBME280_GetTemperature(void* inst);	// degC
+float GroveTempHumiBaroBME280_GetPressure(void* inst);		// Pa
+float GroveTempHumiBaroBME280_GetHumidity(void* inst);		// %RH
+#endif
@@ -0,0 +1,566 @@
+// Host benchmark for the Grove shield library, run against sc18im700-emu or real hardware on a host serial port.
+//
+//   grove-bench [-b baud] [-n iterations] [-i i2c-bus] [-s] [-t max-baud] [-p] [-T capture] [-k] [-O oled] [device]
+//
+// `device` (default /tmp/sc18im700) is exported as GROVE_UART_DEVICE for HostShim's UART_Open.
+// With -i the drivers run on /dev/i2c-N through the i2c-dev backend instead of the bridge.
+// With -s the shield bring-up is skipped and the UART is opened at `baud` directly.
+// With -t the link is tuned up to max-baud after bring-up and the cases run at the rate it settles on.
+// With -T every transaction is traced into `capture` (see grove-trace-dump) and the top talkers are printed.
+// With -k no device is used: the BME280 integer and double compensation kernels are timed and compared.
+// With -p a worker thread reads the BME280 at high priority through the bus arbiter while the cases run.
+// -O selects the OLED controller, ssd1327 (default) or sh1107g; start the emulator with the matching device.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "HAL/GroveShield.h"
+#include "HAL/GroveUART.h"
+#include "HAL/GroveI2C.h"
+#include "HAL/GroveI2CDev.h"
+#include "HAL/GroveI2CBus.h"
+#include "HAL/GroveI2CTrace.h"
+#include "Sensors/GroveTempHumiBaroBME280.h"
+#include "Sensors/GroveBME280Compensation.h"
+#include "Sensors/GroveAD7992.h"
+#include "Sensors/GroveLightSensor.h"
+#include "Sensors/GroveRotaryAngleSensor.h"
+#include "Sensors/GroveLcdRgbBacklight.h"
+#include "Sensors/GroveOledDisplay96x96.h"
+#include "mt3620_rdb.h"
+
+typedef struct
+{
+	const char* Name;
+	int Iterations;
+	void(*Run)(int i);
+}
+BenchCase;
+
+static int i2cFd = -1;
+static void* bme280;
+static void* ad7992;
+static void* lightSensor;
+static void* rotarySensor;
+static uint32_t ad7992Alerts;
+static void* lcd;
+static void* oled;
+static uint8_t oledGray[96 * 96];
+static uint8_t oledImage[GroveOledDisplay_PackedSize(96, 96)];
+static void* bus;
+
+static volatile bool workerStop;
+static uint32_t workerReads;
+
+static uint64_t NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int CompareU64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cases
+
+static void RunBME280(int i)
+{
+	GroveTempHumiBaroBME280_Read(bme280);
+}
+
+static void RunBME280Forced(int i)
+{
+	// Weather-station settings (datasheet 3.5.1): forced mode, x1 everywhere, ~9.3 ms per conversion
+	if (i == 0)
+	{
+		GroveTempHumiBaroBME280Config config;
+		GroveTempHumiBaroBME280_GetDefaultConfig(&config);
+		config.Mode = GroveTempHumiBaroBME280_Mode_Forced;
+		config.TemperatureOversampling = GroveTempHumiBaroBME280_Oversampling_X1;
+		config.PressureOversampling = GroveTempHumiBaroBME280_Oversampling_X1;
+		config.HumidityOversampling = GroveTempHumiBaroBME280_Oversampling_X1;
+		GroveTempHumiBaroBME280_Configure(bme280, &config);
+	}
+	GroveTempHumiBaroBME280_ReadForced(bme280);
+}
+
+static void RunAD7992(int i)
+{
+	GroveAD7992_Read(ad7992, i & 1);
+}
+
+static void RunAD7992Sample(int i)
+{
+	GroveAD7992Sample samples[2];
+	GroveAD7992_Sample(ad7992, GroveAD7992_Channel_All, 0, samples, 2);
+}
+
+static void OnAD7992Alert(void* context, int channel, GroveAD7992_Alert alert)
+{
+	ad7992Alerts++;
+}
+
+static void PrintAD7992Capture(uint32_t rateHz, int count)
+{
+	GroveAD7992Sample* samples = (GroveAD7992Sample*)malloc(sizeof(GroveAD7992Sample) * (size_t)count);
+
+	int filled = GroveAD7992_Sample(ad7992, GroveAD7992_Channel_All, rateHz, samples, count);
+	if (filled >= 4)
+	{
+		uint32_t spanUs = samples[filled - 1].TimestampUs - samples[0].TimestampUs;
+		int cycles = filled / 2 - 1;
+		printf("AD7992: %d samples, requested %u Hz, achieved %.1f Hz per channel; VIN1 %.3f, VIN2 %.3f\n",
+			filled, rateHz, spanUs > 0 ? cycles * 1e6 / spanUs : 0.0,
+			GroveAD7992_RawToFloat(samples[filled - 2].Raw), GroveAD7992_RawToFloat(samples[filled - 1].Raw));
+	}
+
+	free(samples);
+}
+
+static void RunAD7992AlertPoll(int i)
+{
+	// Limits around the middle of the VIN1 swing; with the pin idle this is a GPIO read and nothing else
+	if (i == 0)
+	{
+		GroveAD7992_SetLimits(ad7992, 0, 1000, 3000, 64);
+		GroveAD7992_StartAlerts(ad7992, GroveAD7992_Channel_1, GroveAD7992_Cycle_X2048, OnAD7992Alert, NULL);
+	}
+	GroveAD7992_PollAlerts(ad7992);
+}
+
+static void RunLightSensor(int i)
+{
+	GroveLightSensor_Read(lightSensor);
+}
+
+static void RunRotarySensor(int i)
+{
+	GroveRotaryAngleSensor_Read(rotarySensor);
+}
+
+static void RunAnalogPair(int i)
+{
+	GroveLightSensor_Read(lightSensor);
+	GroveRotaryAngleSensor_Read(rotarySensor);
+}
+
+static void RunLcdBacklight(int i)
+{
+	GroveLcdRgbBacklight_SetBacklightRgb(lcd, (uint8_t)i, 128, 255);
+}
+
+static void PrintLcdFade(int durationMs)
+{
+	// Animate is polled every 5 ms, faster than the default 50 Hz cap, as a busy event loop would
+	static const struct timespec poll = { 0, 5000000 };
+	GroveUARTStats before, after;
+	GroveUART_GetStats(i2cFd, &before);
+
+	GroveLcdRgbBacklight_SetBacklightRgb(lcd, 0, 0, 0);
+	GroveLcdRgbBacklight_FadeTo(lcd, 30, 156, 142, (uint32_t)durationMs, GroveLcdRgbBacklight_Ease_InOut);
+	int calls = 0;
+	uint64_t start = NowNs();
+	while (GroveLcdRgbBacklight_Animate(lcd))
+	{
+		calls++;
+		nanosleep(&poll, NULL);
+	}
+
+	GroveUART_GetStats(i2cFd, &after);
+	printf("LCD backlight fade: %d ms, %d steps polled, %u bridge trips\n",
+		(int)((NowNs() - start) / 1000000), calls, after.Requests - before.Requests);
+}
+
+static void RunLcdText(int i)
+{
+	// A reading refreshed in place: only the digits that changed go out, the degree sign is uploaded once
+	static const uint8_t degree[8] = { 0x06, 0x09, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00 };
+	GroveLcdRgbBacklight_Printf(lcd, 0, 0, "Temp %5.1f %cC", 20.0 + (i % 100) * 0.1, GroveLcdRgbBacklight_Glyph(lcd, degree));
+	GroveLcdRgbBacklight_Printf(lcd, 1, 0, "RH   %3d %%", 40 + i / 10 % 20);
+	GroveLcdRgbBacklight_Update(lcd);
+}
+
+static void RunLcdBarGraph(int i)
+{
+	// A level sweeping up and down; after the first pass the four partial-cell glyphs stay resident
+	int level = i % 160 < 80 ? i % 160 : 160 - i % 160;
+	GroveLcdRgbBacklight_BarGraph(lcd, 1, 0, 16, level, 80);
+	GroveLcdRgbBacklight_Update(lcd);
+}
+
+static void RunOledText(int i)
+{
+	GroveOledDisplay_SetTextXY(oled, (unsigned char)(i % 12), 0);
+	GroveOledDisplay_PutString(oled, "Grove 96x96");
+}
+
+static void RunOledFbText(int i)
+{
+	// A changing counter on one text line, drawn in RAM and flushed as a dirty window
+	char text[16];
+	snprintf(text, sizeof(text), "n=%d", i);
+	GroveOledDisplay_FbDrawString(oled, 0, 40, text);
+	GroveOledDisplay_Flush(oled);
+}
+
+static void PrintOledTicker(int durationMs)
+{
+	// A scrolling status line with a counter flushed elsewhere on the panel, against a software scroll of the band
+	if (!GroveOledDisplay_TickerStart(oled, 88, "Temperature 23.5C  Humidity 41%  ", Scroll_2Frames, 0)) return;
+
+	static const struct timespec poll = { 0, 5000000 };
+	uint64_t start = NowNs();
+	for (int n = 0; NowNs() - start < (uint64_t)durationMs * 1000000; n++)
+	{
+		GroveOledDisplay_TickerUpdate(oled);
+		if (n % 50 == 0)
+		{
+			char text[16];
+			snprintf(text, sizeof(text), "t=%d", n / 50);
+			GroveOledDisplay_FbDrawString(oled, 0, 40, text);
+			GroveOledDisplay_Flush(oled);
+		}
+		nanosleep(&poll, NULL);
+	}
+	GroveOledDisplay_TickerStop(oled);
+
+	GroveOledDisplayTickerStats stats;
+	GroveOledDisplay_GetTickerStats(oled, &stats);
+	printf("OLED ticker: %u segments in %u ms, %u B/s sent, %u B/s to redraw the band every step (%.1fx)\n",
+		stats.Segments, stats.ElapsedMs, stats.TxBytesPerSecond, stats.RedrawBytesPerSecond,
+		stats.TxBytes > 0 ? (double)stats.RedrawBytes / stats.TxBytes : 0.0);
+}
+
+static void RunOledPack(int i)
+{
+	GroveOledDisplay_PackGray(oledGray, 96, 96, 96, GroveOledDisplay_Dither_FloydSteinberg, oledImage);
+}
+
+static void RunOledImage(int i)
+{
+	// The asset packed by oled.pack, blitted as it is
+	GroveOledDisplay_DrawImage(oled, 0, 0, 96, 96, oledImage);
+}
+
+static void RunOledClear(int i)
+{
+	GroveOledDisplay_ClearDisplay(oled);
+}
+
+static void RunOledFill(int i)
+{
+	GroveOledDisplay_FillDisplay(oled, (unsigned char)(i & 0x0F));
+}
+
+static void* SensorWorker(void* arg)
+{
+	while (!workerStop)
+	{
+		GroveTempHumiBaroBME280_Read(bme280);
+		workerReads++;
+	}
+	return NULL;
+}
+
+static void PrintBusStats(void)
+{
+	static const char* names[GroveI2CBus_Priority_Count] = { "low", "normal", "high" };
+	GroveI2CBusStats stats;
+	GroveI2CBus_GetStats(bus, &stats);
+
+	printf("\nBus arbiter: %u transactions, %u worker reads\n", stats.Transactions, workerReads);
+	for (int p = 0; p < GroveI2CBus_Priority_Count; p++)
+	{
+		const GroveI2CBusLockStats* s = &stats.Priority[p];
+		if (s->Acquisitions == 0) continue;
+		printf("  %-8s %8u acquisitions, %8u contended, mean wait %8.3f ms, max wait %8.3f ms\n",
+			names[p], s->Acquisitions, s->Contended,
+			s->Contended > 0 ? (double)s->WaitNs / s->Contended / 1e6 : 0.0, (double)s->MaxWaitNs / 1e6);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BME280 kernels
+
+#define KERNEL_SAMPLES	200000
+
+// Bosch datasheet example trim, as served by the emulator
+static const uint8_t kernelCalib00[GROVE_BME280_CALIB00_SIZE] =
+{
+	0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,
+	0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17, 0x00, 0x4B,
+};
+static const uint8_t kernelCalib26[GROVE_BME280_CALIB26_SIZE] = { 0x6A, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E };
+
+static int RunKernelBench(void)
+{
+	GroveBME280Calibration cal;
+	GroveBME280Compensation_ParseCalibration(&cal, kernelCalib00, kernelCalib26);
+
+	// Raw readings spread over roughly -40..85 degC, 300..1100 hPa and the full humidity range
+	GroveBME280Raw* raw = (GroveBME280Raw*)malloc(sizeof(GroveBME280Raw) * KERNEL_SAMPLES);
+	uint32_t seed = 1;
+	for (int i = 0; i < KERNEL_SAMPLES; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		raw[i].Temperature = 380000 + (int32_t)((seed >> 8) % 280000);
+		seed = seed * 1103515245u + 12345u;
+		raw[i].Pressure = 250000 + (int32_t)((seed >> 8) % 450000);
+		seed = seed * 1103515245u + 12345u;
+		raw[i].Humidity = (int32_t)((seed >> 8) % 65536);
+	}
+
+	// Accuracy: integer results against the double reference
+	double maxT = 0, maxP = 0, maxH = 0, sumT = 0, sumP = 0, sumH = 0;
+	int compared = 0;
+	for (int i = 0; i < KERNEL_SAMPLES; i++)
+	{
+		int32_t t_fine;
+		double t_fineD;
+		double t = GroveBME280Compensation_Temperature(&cal, raw[i].Temperature, &t_fineD);
+		double p = GroveBME280Compensation_Pressure(&cal, raw[i].Pressure, t_fineD);
+		double h = GroveBME280Compensation_Humidity(&cal, raw[i].Humidity, t_fineD);
+		if (t < -40 || t > 85 || p < 30000 || p > 110000) continue;
+
+		double dt = fabs(GroveBME280Compensation_TemperatureInt(&cal, raw[i].Temperature, &t_fine) / 100.0 - t);
+		double dp = fabs(GroveBME280Compensation_PressureInt(&cal, raw[i].Pressure, t_fine) / 256.0 - p);
+		double dh = fabs(GroveBME280Compensation_HumidityInt(&cal, raw[i].Humidity, t_fine) / 1024.0 - h);
+		if (dt > maxT) maxT = dt;
+		if (dp > maxP) maxP = dp;
+		if (dh > maxH) maxH = dh;
+		sumT += dt;
+		sumP += dp;
+		sumH += dh;
+		compared++;
+	}
+
+	// Speed: both kernels over the same samples
+	volatile uint32_t sinkInt = 0;
+	volatile double sinkDouble = 0;
+	uint64_t t0 = NowNs();
+	for (int i = 0; i < KERNEL_SAMPLES; i++)
+	{
+		int32_t t_fine;
+		uint32_t v = (uint32_t)GroveBME280Compensation_TemperatureInt(&cal, raw[i].Temperature, &t_fine);
+		v += GroveBME280Compensation_PressureInt(&cal, raw[i].Pressure, t_fine);
+		v += GroveBME280Compensation_HumidityInt(&cal, raw[i].Humidity, t_fine);
+		sinkInt += v;
+	}
+	uint64_t t1 = NowNs();
+	for (int i = 0; i < KERNEL_SAMPLES; i++)
+	{
+		double t_fine;
+		double v = GroveBME280Compensation_Temperature(&cal, raw[i].Temperature, &t_fine);
+		v += GroveBME280Compensation_Pressure(&cal, raw[i].Pressure, t_fine);
+		v += GroveBME280Compensation_Humidity(&cal, raw[i].Humidity, t_fine);
+		sinkDouble += v;
+	}
+	uint64_t t2 = NowNs();
+	free(raw);
+
+	printf("BME280 compensation, %d samples (%d in range)\n", KERNEL_SAMPLES, compared);
+	printf("  integer %8.1f ns/sample\n", (double)(t1 - t0) / KERNEL_SAMPLES);
+	printf("  double  %8.1f ns/sample\n", (double)(t2 - t1) / KERNEL_SAMPLES);
+	printf("  |int - double|: temperature max %.4f mean %.4f degC, pressure max %.3f mean %.3f Pa, humidity max %.4f mean %.4f %%RH\n",
+		maxT, sumT / compared, maxP, sumP / compared, maxH, sumH / compared);
+
+	// Integer temperature is truncated to 0.01 degC, the rest should agree to a few LSBs of their fixed-point unit
+	bool ok = maxT <= 0.01 && maxP <= 2.0 && maxH <= 0.05;
+	printf("  %s\n", ok ? "within tolerance" : "OUT OF TOLERANCE");
+	return ok ? 0 : 1;
+}
+
+static void RunCase(const BenchCase* c)
+{
+	uint64_t* samples = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)c->Iterations);
+	GroveUARTStats before, after;
+
+	GroveUART_GetStats(i2cFd, &before);
+	uint64_t start = NowNs();
+	for (int i = 0; i < c->Iterations; i++)
+	{
+		uint64_t t0 = NowNs();
+		c->Run(i);
+		samples[i] = NowNs() - t0;
+	}
+	uint64_t total = NowNs() - start;
+	GroveUART_GetStats(i2cFd, &after);
+
+	qsort(samples, (size_t)c->Iterations, sizeof(uint64_t), CompareU64);
+	double n = (double)c->Iterations;
+
+	printf("%-20s %6d %10.3f %10.3f %10.3f %9.1f %9.1f %9.1f %9.1f\n",
+		c->Name, c->Iterations,
+		(double)total / n / 1e6,
+		(double)samples[c->Iterations / 2] / 1e6,
+		(double)samples[(c->Iterations * 99) / 100] / 1e6,
+		(double)(after.Requests - before.Requests) / n,
+		(double)(after.WriteCalls + after.ReadCalls - before.WriteCalls - before.ReadCalls) / n,
+		(double)(after.TxBytes - before.TxBytes) / n,
+		(double)(after.RxBytes - before.RxBytes) / n);
+
+	free(samples);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t baud = 115200;
+	int iterations = 50;
+	int i2cBus = -1;
+	bool skipBringUp = false;
+	uint32_t tuneBaud = 0;
+	bool parallel = false;
+	const char* tracePath = NULL;
+	bool kernelBench = false;
+	uint8_t oledIC = SSD1327;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "b:n:i:st:pT:kO:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'b': baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'n': iterations = atoi(optarg); break;
+		case 'i': i2cBus = atoi(optarg); break;
+		case 's': skipBringUp = true; break;
+		case 't': tuneBaud = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'p': parallel = true; break;
+		case 'T': tracePath = optarg; break;
+		case 'k': kernelBench = true; break;
+		case 'O': oledIC = strcmp(optarg, "sh1107g") == 0 ? SH1107G : SSD1327; break;
+		default:
+			fprintf(stderr, "usage: %s [-b baud] [-n iterations] [-i i2c-bus] [-s] [-t max-baud] [-p] [-T capture] [-k] [-O oled] [device]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (optind < argc) setenv("GROVE_UART_DEVICE", argv[optind], 1);
+	if (iterations < 1) iterations = 1;
+	if (kernelBench) return RunKernelBench();
+
+	uint64_t t0 = NowNs();
+	if (i2cBus >= 0)
+	{
+		i2cFd = GroveI2CDev_Open(i2cBus);
+		GroveI2C_SelectBackend(GroveI2C_Backend_I2cDev);
+	}
+	else if (skipBringUp)
+	{
+		i2cFd = GroveUART_Open(MT3620_RDB_HEADER2_ISU0_UART, baud);
+	}
+	else
+	{
+		GroveShield_Initialize(&i2cFd, baud);
+	}
+	printf("Shield initialization: %.3f ms (fd %d)\n", (double)(NowNs() - t0) / 1e6, i2cFd);
+	if (i2cFd < 0) return 1;
+
+	if (tuneBaud != 0 && i2cBus < 0)
+	{
+		GroveShieldLinkInfo link;
+		if (!GroveShield_TuneLink(&i2cFd, tuneBaud, &link)) return 1;
+		printf("Link tuning: %u baud, %u bytes/s, %u steps, %u ms\n", link.BaudRate, link.BytesPerSecond, link.Steps, link.ElapsedMs);
+	}
+	printf("\n");
+
+	if (tracePath != NULL && !GroveI2CTrace_Enable(tracePath))
+	{
+		perror(tracePath);
+		return 1;
+	}
+
+	bme280 = GroveTempHumiBaroBME280_Open(i2cFd);
+	if (bme280 != NULL)
+	{
+		GroveTempHumiBaroBME280_Read(bme280);
+		printf("BME280: %.2f degC, %.2f hPa, %.2f %%RH\n", GroveTempHumiBaroBME280_GetTemperature(bme280),
+			GroveTempHumiBaroBME280_GetPressure(bme280) / 100.0, GroveTempHumiBaroBME280_GetHumidity(bme280));
+	}
+	ad7992 = GroveAD7992_Open(i2cFd);
+	PrintAD7992Capture(500, 200);
+	lightSensor = GroveLightSensor_Init(i2cFd, 0);
+	rotarySensor = GroveRotaryAngleSensor_Init(i2cFd, 1);
+	lcd = GroveLcdRgbBacklight_Open(i2cFd);
+	PrintLcdFade(1000);
+	oled = GroveOledDisplay_Open(i2cFd, oledIC);
+	GroveOledDisplay_FbClear(oled, 0);
+	GroveOledDisplay_FbDrawString(oled, 0, 0, "Grove 96x96");
+	printf("OLED framebuffer: first flush %d bytes\n", GroveOledDisplay_Flush(oled));
+	if (oledIC == SSD1327) PrintOledTicker(2000);
+	for (int y = 0; y < 96; y++)
+	{
+		// Radial gradient, a worst case for banding without dithering
+		for (int x = 0; x < 96; x++)
+		{
+			int d = (int)sqrt((double)((x - 48) * (x - 48) + (y - 48) * (y - 48)));
+			oledGray[y * 96 + x] = (uint8_t)(d * 255 / 68);
+		}
+	}
+
+	pthread_t worker;
+	if (parallel && bme280 != NULL)
+	{
+		bus = GroveI2CBus_Open(i2cFd);
+		GroveI2CBus_SetDevicePriority(bus, 0x76 << 1, GroveI2CBus_Priority_High);
+		GroveI2CBus_SetDevicePriority(bus, 0x3C << 1, GroveI2CBus_Priority_Low);
+		pthread_create(&worker, NULL, SensorWorker, NULL);
+	}
+
+	const BenchCase cases[] =
+	{
+		{ "bme280.read", iterations, RunBME280 },
+		{ "bme280.forced", iterations, RunBME280Forced },
+		{ "ad7992.read", iterations, RunAD7992 },
+		{ "ad7992.sample", iterations, RunAD7992Sample },
+		{ "ad7992.alertpoll", iterations, RunAD7992AlertPoll },
+		{ "light.read", iterations, RunLightSensor },
+		{ "rotary.read", iterations, RunRotarySensor },
+		{ "analog.pair", iterations, RunAnalogPair },
+		{ "lcd.backlight", iterations, RunLcdBacklight },
+		{ "lcd.text", iterations, RunLcdText },
+		{ "lcd.bargraph", iterations, RunLcdBarGraph },
+		{ "oled.text", iterations, RunOledText },
+		{ "oled.fbtext", iterations, RunOledFbText },
+		{ "oled.pack", iterations, RunOledPack },
+		{ "oled.image", iterations, RunOledImage },
+		{ "oled.clear", iterations, RunOledClear },
+		{ "oled.fill", iterations, RunOledFill },
+	};
+
+	printf("%-20s %6s %10s %10s %10s %9s %9s %9s %9s\n", "case", "iters", "mean ms", "p50 ms", "p99 ms", "trips/op", "calls/op", "tx B/op", "rx B/op");
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		if (bme280 == NULL && (cases[i].Run == RunBME280 || cases[i].Run == RunBME280Forced)) continue;
+		RunCase(&cases[i]);
+	}
+
+	if (bus != NULL)
+	{
+		workerStop = true;
+		pthread_join(worker, NULL);
+		PrintBusStats();
+		GroveI2CBus_Close(bus);
+	}
+
+	if (tracePath != NULL)
+	{
+		printf("\n");
+		GroveI2CTrace_LogSummary();
+		if (GroveI2CTrace_GetCaptureLost() > 0) printf("trace capture incomplete, %u transactions lost\n", GroveI2CTrace_GetCaptureLost());
+		GroveI2CTrace_Disable();
+	}
+
+	return 0;
+}
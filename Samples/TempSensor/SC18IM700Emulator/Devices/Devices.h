@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../Emulator.h"
+
+// Simulated I2C parts found on the Grove shield. Each returns a heap-allocated device ready for Emulator_AddDevice().
+
+EmuDevice* EmuBME280_Create(void);
+EmuDevice* EmuAD7992_Create(void);
+EmuDevice* EmuLcdText_Create(void);
+EmuDevice* EmuLcdRgb_Create(void);
+EmuDevice* EmuSSD1327_Create(void);
+EmuDevice* EmuSH1107G_Create(void);		// same address as the SSD1327, add one or the other
+
+// Write the OLED GDDRAM as a 128x128 PGM image.
+bool EmuSSD1327_SavePgm(EmuDevice* dev, const char* path);
+bool EmuSH1107G_SavePgm(EmuDevice* dev, const char* path);
+
+// Shared by device models that sample time-varying signals.
+uint64_t Emu_NowNs(void);
@@ -0,0 +1,191 @@
+#include "Devices.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define AD7992_ADDRESS		0x20
+
+#define REG_RESULT			0x0
+#define REG_ALERT_STATUS	0x1
+#define REG_CONFIG			0x2
+#define REG_CYCLE			0x3
+#define REG_LIMITS			0x4		// DATA_LOW/DATA_HIGH/HYSTERESIS for CH1, then CH2
+#define REG_COUNT			0xA
+
+typedef struct
+{
+	uint8_t Pointer;
+	uint16_t Regs[REG_COUNT];
+	int NextChannel;		// mode 1 sequencing position
+	int ReadIndex;			// position within a multi-channel mode 2 read
+	uint16_t Words[2];
+	int WordCount;
+	uint32_t Conversions;
+}
+EmuAD7992;
+
+uint64_t Emu_NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint16_t sample(int channel)
+{
+	double t = (double)Emu_NowNs() / 1e9;
+
+	// VIN1: 2 Hz sine around mid scale; VIN2: 10 s sawtooth
+	double v = channel == 0 ? 2048.0 + 1500.0 * sin(2.0 * M_PI * 2.0 * t) : fmod(t, 10.0) / 10.0 * 4095.0;
+	return (uint16_t)v & 0x0FFF;
+}
+
+static uint16_t convert(EmuAD7992* this, int channel)
+{
+	uint16_t value = sample(channel);
+	this->Conversions++;
+
+	// Out-of-window results latch the alert status and flag bit
+	uint16_t low = this->Regs[REG_LIMITS + channel * 3] & 0x0FFF;
+	uint16_t high = this->Regs[REG_LIMITS + channel * 3 + 1] & 0x0FFF;
+	uint16_t flag = 0;
+	if (value < low)
+	{
+		this->Regs[REG_ALERT_STATUS] |= (uint16_t)(0x01 << (channel * 2));
+		flag = 0x8000;
+	}
+	else if (value > high)
+	{
+		this->Regs[REG_ALERT_STATUS] |= (uint16_t)(0x02 << (channel * 2));
+		flag = 0x8000;
+	}
+
+	return (uint16_t)(flag | (channel << 12) | value);
+}
+
+static void prepare_result(EmuAD7992* this)
+{
+	uint8_t channels = this->Pointer >> 4;
+
+	this->WordCount = 0;
+	if (channels != 0)
+	{
+		// Mode 2: the pointer's channel bits start one conversion per selected channel
+		if (channels & 0x1) this->Words[this->WordCount++] = convert(this, 0);
+		if (channels & 0x2) this->Words[this->WordCount++] = convert(this, 1);
+		return;
+	}
+
+	// Mode 1: each CONVST converts the next channel selected in the configuration register
+	uint8_t selected = (this->Regs[REG_CONFIG] >> 4) & 0x3;
+	if (selected == 0) selected = 0x1;
+	for (int i = 0; i < 2; i++)
+	{
+		int channel = (this->NextChannel + i) % 2;
+		if (selected & (1 << channel))
+		{
+			this->Words[this->WordCount++] = convert(this, channel);
+			this->NextChannel = channel + 1;
+			return;
+		}
+	}
+}
+
+static bool ad7992_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuAD7992* this = (EmuAD7992*)dev->State;
+	if (dataSize == 0) return true;
+
+	this->Pointer = data[0];
+	this->ReadIndex = 0;
+	this->WordCount = 0;
+
+	uint8_t reg = this->Pointer & 0x0F;
+	if (reg >= REG_COUNT || dataSize < 2) return true;
+
+	if (reg == REG_CONFIG || reg == REG_CYCLE)
+	{
+		this->Regs[reg] = data[1];
+	}
+	else if (reg == REG_ALERT_STATUS)
+	{
+		// Writing ones clears the latched alerts
+		this->Regs[reg] &= (uint16_t)~data[1];
+	}
+	else if (reg >= REG_LIMITS && dataSize >= 3)
+	{
+		this->Regs[reg] = (uint16_t)(data[1] << 8 | data[2]);
+	}
+	return true;
+}
+
+static void ad7992_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	EmuAD7992* this = (EmuAD7992*)dev->State;
+	uint8_t reg = this->Pointer & 0x0F;
+
+	if (reg == REG_CONFIG || reg == REG_CYCLE || reg == REG_ALERT_STATUS)
+	{
+		memset(data, (uint8_t)this->Regs[reg], (size_t)dataSize);
+		return;
+	}
+
+	for (int i = 0; i < dataSize; i++)
+	{
+		uint16_t word;
+		if (reg == REG_RESULT)
+		{
+			if (this->ReadIndex / 2 >= this->WordCount)
+			{
+				prepare_result(this);
+				this->ReadIndex = 0;
+			}
+			word = this->Words[this->ReadIndex / 2];
+		}
+		else
+		{
+			word = reg < REG_COUNT ? this->Regs[reg] : 0;
+		}
+
+		// Big endian on the wire
+		data[i] = (this->ReadIndex % 2) == 0 ? (uint8_t)(word >> 8) : (uint8_t)word;
+		this->ReadIndex++;
+	}
+}
+
+static void ad7992_report(EmuDevice* dev)
+{
+	EmuAD7992* this = (EmuAD7992*)dev->State;
+
+	fprintf(stderr, "           %u conversions, config 0x%02X, cycle 0x%02X, alert status 0x%02X\n",
+		this->Conversions, this->Regs[REG_CONFIG], this->Regs[REG_CYCLE], this->Regs[REG_ALERT_STATUS]);
+	for (int channel = 0; channel < 2; channel++)
+	{
+		const uint16_t* limits = &this->Regs[REG_LIMITS + channel * 3];
+		fprintf(stderr, "           VIN%d limits %u..%u, hysteresis %u\n", channel + 1, limits[0], limits[1], limits[2]);
+	}
+}
+
+EmuDevice* EmuAD7992_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuAD7992* this = (EmuAD7992*)calloc(1, sizeof(EmuAD7992));
+
+	// Power-on limits: full scale window, no alerts
+	for (int channel = 0; channel < 2; channel++)
+	{
+		this->Regs[REG_LIMITS + channel * 3] = 0x0000;
+		this->Regs[REG_LIMITS + channel * 3 + 1] = 0x0FFF;
+	}
+
+	dev->Address = AD7992_ADDRESS;
+	dev->Name = "AD7992";
+	dev->State = this;
+	dev->Write = ad7992_write;
+	dev->Read = ad7992_read;
+	dev->Report = ad7992_report;
+
+	return dev;
+}
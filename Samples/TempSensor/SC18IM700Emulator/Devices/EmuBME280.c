@@ -0,0 +1,178 @@
+#include "Devices.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BME280_ADDRESS		0x76
+
+#define REG_CALIB00			0x88
+#define REG_CHIPID			0xD0
+#define REG_RESET			0xE0
+#define REG_CALIB26			0xE1
+#define REG_CTRL_HUM		0xF2
+#define REG_STATUS			0xF3
+#define REG_CTRL_MEAS		0xF4
+#define REG_DATA			0xF7
+
+typedef struct
+{
+	uint8_t Regs[256];
+	uint8_t Pointer;
+	uint32_t Conversions;
+	uint32_t Forced;
+	uint32_t EarlyReads;		// data reads while a forced conversion was still running
+	bool Measuring;
+	uint64_t ReadyNs;
+}
+EmuBME280;
+
+// Calibration and raw readings from the Bosch datasheet example (about 25 C, 1006 hPa) plus a typical humidity trim
+static const uint8_t calib00[26] =
+{
+	0x70, 0x6B,		// dig_T1 27504
+	0x43, 0x67,		// dig_T2 26435
+	0x18, 0xFC,		// dig_T3 -1000
+	0x7D, 0x8E,		// dig_P1 36477
+	0x43, 0xD6,		// dig_P2 -10685
+	0xD0, 0x0B,		// dig_P3 3024
+	0x27, 0x0B,		// dig_P4 2855
+	0x8C, 0x00,		// dig_P5 140
+	0xF9, 0xFF,		// dig_P6 -7
+	0x8C, 0x3C,		// dig_P7 15500
+	0xF8, 0xC6,		// dig_P8 -14600
+	0x70, 0x17,		// dig_P9 6000
+	0x00,
+	0x4B,			// dig_H1 75
+};
+
+static const uint8_t calib26[7] =
+{
+	0x6A, 0x01,		// dig_H2 362
+	0x00,			// dig_H3 0
+	0x13, 0x29,		// dig_H4 313 (0x13 << 4 | 0x9)
+	0x03,			// dig_H5 50 (0x03 << 4 | 0x2)
+	0x1E,			// dig_H6 30
+};
+
+static void convert(EmuBME280* this)
+{
+	uint32_t adc_P = 415148;
+	uint32_t adc_T = 519888 + (this->Conversions % 16) * 16;
+	uint32_t adc_H = 30000;
+
+	uint8_t* d = &this->Regs[REG_DATA];
+	d[0] = (uint8_t)(adc_P >> 12);
+	d[1] = (uint8_t)(adc_P >> 4);
+	d[2] = (uint8_t)(adc_P << 4);
+	d[3] = (uint8_t)(adc_T >> 12);
+	d[4] = (uint8_t)(adc_T >> 4);
+	d[5] = (uint8_t)(adc_T << 4);
+	d[6] = (uint8_t)(adc_H >> 8);
+	d[7] = (uint8_t)adc_H;
+
+	this->Conversions++;
+}
+
+// Datasheet 9.1 maximum measurement time for the oversampling settings
+static uint64_t measurement_ns(const EmuBME280* this)
+{
+	static const uint32_t factor[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+	uint32_t t = factor[(this->Regs[REG_CTRL_MEAS] >> 5) & 7];
+	uint32_t p = factor[(this->Regs[REG_CTRL_MEAS] >> 2) & 7];
+	uint32_t h = factor[this->Regs[REG_CTRL_HUM] & 7];
+
+	uint64_t us = 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+	return us * 1000;
+}
+
+static void update_measuring(EmuBME280* this)
+{
+	if (this->Measuring && Emu_NowNs() >= this->ReadyNs)
+	{
+		this->Measuring = false;
+		convert(this);
+	}
+	this->Regs[REG_STATUS] = this->Measuring ? 0x08 : 0x00;
+}
+
+static bool bme280_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuBME280* this = (EmuBME280*)dev->State;
+	if (dataSize == 0) return true;
+
+	// A lone byte sets the read pointer; longer writes are register/value pairs
+	this->Pointer = data[0];
+	for (int i = 0; i + 1 < dataSize; i += 2)
+	{
+		uint8_t reg = data[i];
+		uint8_t val = data[i + 1];
+
+		if (reg == REG_RESET && val == 0xB6)
+		{
+			this->Regs[REG_CTRL_HUM] = 0;
+			this->Regs[REG_CTRL_MEAS] = 0;
+			continue;
+		}
+		if (reg < 0xF2 || reg > 0xF5 || reg == REG_STATUS) continue;
+
+		this->Regs[reg] = val;
+		if (reg == REG_CTRL_MEAS && (val & 0x03) == 0x03)
+		{
+			convert(this);
+		}
+		else if (reg == REG_CTRL_MEAS && (val & 0x03) != 0)
+		{
+			// Forced mode: results appear after the measurement time, then the part drops back to sleep
+			this->Forced++;
+			this->Measuring = true;
+			this->ReadyNs = Emu_NowNs() + measurement_ns(this);
+			this->Regs[REG_CTRL_MEAS] = val & 0xFC;
+		}
+	}
+	return true;
+}
+
+static void bme280_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	EmuBME280* this = (EmuBME280*)dev->State;
+
+	// Normal mode keeps producing fresh samples
+	if (this->Pointer == REG_DATA && (this->Regs[REG_CTRL_MEAS] & 0x03) == 0x03) convert(this);
+
+	update_measuring(this);
+	if (this->Measuring && this->Pointer + dataSize > REG_DATA) this->EarlyReads++;
+
+	for (int i = 0; i < dataSize; i++)
+	{
+		data[i] = this->Regs[this->Pointer];
+		this->Pointer++;
+	}
+}
+
+static void bme280_report(EmuDevice* dev)
+{
+	EmuBME280* this = (EmuBME280*)dev->State;
+
+	fprintf(stderr, "           %u conversions, %u forced, %u reads before data ready, ctrl_meas 0x%02X ctrl_hum 0x%02X config 0x%02X\n",
+		this->Conversions, this->Forced, this->EarlyReads, this->Regs[REG_CTRL_MEAS], this->Regs[REG_CTRL_HUM], this->Regs[0xF5]);
+}
+
+EmuDevice* EmuBME280_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuBME280* this = (EmuBME280*)calloc(1, sizeof(EmuBME280));
+
+	memcpy(&this->Regs[REG_CALIB00], calib00, sizeof(calib00));
+	memcpy(&this->Regs[REG_CALIB26], calib26, sizeof(calib26));
+	this->Regs[REG_CHIPID] = 0x60;
+	convert(this);
+
+	dev->Address = BME280_ADDRESS;
+	dev->Name = "BME280";
+	dev->State = this;
+	dev->Write = bme280_write;
+	dev->Read = bme280_read;
+	dev->Report = bme280_report;
+
+	return dev;
+}
@@ -0,0 +1,197 @@
+#include "Devices.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Grove LCD RGB Backlight: an HD44780-compatible text controller behind an I2C front end, and a PCA9633 LED driver.
+
+#define LCD_TEXT_ADDRESS	0x3E
+#define LCD_RGB_ADDRESS		0x62
+
+#define CTRL_CO				0x80	// another control byte follows the next byte
+#define CTRL_RS				0x40	// the next byte(s) are data, not commands
+
+#define DDRAM_LINE			0x40
+#define DDRAM_WIDTH			40
+
+typedef struct
+{
+	char Ddram[2][DDRAM_WIDTH];
+	uint8_t Cgram[64];
+	uint8_t Address;
+	bool CgramMode;
+	uint32_t Commands;
+	uint32_t DataWrites;
+	uint32_t CgramWrites;
+}
+EmuLcdText;
+
+typedef struct
+{
+	uint8_t Regs[16];
+	uint32_t Writes;
+}
+EmuLcdRgb;
+
+////////////////////////////////////////////////////////////////////////////////
+// Text controller
+
+static void text_command(EmuLcdText* this, uint8_t cmd)
+{
+	this->Commands++;
+
+	if (cmd & 0x80)
+	{
+		this->Address = cmd & 0x7F;
+		this->CgramMode = false;
+	}
+	else if (cmd & 0x40)
+	{
+		this->Address = cmd & 0x3F;
+		this->CgramMode = true;
+	}
+	else if (cmd == 0x01)
+	{
+		memset(this->Ddram, ' ', sizeof(this->Ddram));
+		this->Address = 0;
+		this->CgramMode = false;
+	}
+	else if ((cmd & 0xFE) == 0x02)
+	{
+		this->Address = 0;
+		this->CgramMode = false;
+	}
+}
+
+static void text_data(EmuLcdText* this, uint8_t data)
+{
+	if (this->CgramMode)
+	{
+		this->CgramWrites++;
+		this->Cgram[this->Address & 0x3F] = data;
+		this->Address = (uint8_t)((this->Address + 1) & 0x3F);
+		return;
+	}
+
+	this->DataWrites++;
+	int line = (this->Address & DDRAM_LINE) ? 1 : 0;
+	int column = (this->Address & 0x3F) % DDRAM_WIDTH;
+	this->Ddram[line][column] = (char)data;
+
+	column++;
+	if (column >= DDRAM_WIDTH)
+	{
+		column = 0;
+		line ^= 1;
+	}
+	this->Address = (uint8_t)((line ? DDRAM_LINE : 0) | column);
+}
+
+static bool text_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuLcdText* this = (EmuLcdText*)dev->State;
+
+	int i = 0;
+	while (i < dataSize)
+	{
+		uint8_t control = data[i++];
+		bool last = (control & CTRL_CO) == 0;
+		bool isData = (control & CTRL_RS) != 0;
+
+		do
+		{
+			if (i >= dataSize) return true;
+			if (isData) text_data(this, data[i]);
+			else text_command(this, data[i]);
+			i++;
+		} while (last);
+	}
+	return true;
+}
+
+static void text_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	memset(data, 0, (size_t)dataSize);
+}
+
+static void text_report(EmuDevice* dev)
+{
+	EmuLcdText* this = (EmuLcdText*)dev->State;
+
+	fprintf(stderr, "           %u commands, %u DDRAM writes, %u CGRAM writes\n", this->Commands, this->DataWrites, this->CgramWrites);
+	for (int line = 0; line < 2; line++)
+	{
+		fprintf(stderr, "           |");
+		for (int column = 0; column < 16; column++)
+		{
+			char c = this->Ddram[line][column];
+			fputc((c >= 0x20 && c < 0x7F) ? c : '#', stderr);
+		}
+		fprintf(stderr, "|\n");
+	}
+}
+
+EmuDevice* EmuLcdText_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuLcdText* this = (EmuLcdText*)calloc(1, sizeof(EmuLcdText));
+
+	memset(this->Ddram, ' ', sizeof(this->Ddram));
+
+	dev->Address = LCD_TEXT_ADDRESS;
+	dev->Name = "LCD";
+	dev->State = this;
+	dev->Write = text_write;
+	dev->Read = text_read;
+	dev->Report = text_report;
+
+	return dev;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RGB backlight
+
+static bool rgb_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuLcdRgb* this = (EmuLcdRgb*)dev->State;
+	if (dataSize == 0) return true;
+
+	// Control byte: register address in the low nibble, auto-increment in the top bits
+	uint8_t reg = data[0] & 0x0F;
+	bool autoIncrement = (data[0] & 0xE0) != 0;
+	for (int i = 1; i < dataSize; i++)
+	{
+		this->Regs[reg] = data[i];
+		this->Writes++;
+		if (autoIncrement) reg = (uint8_t)((reg + 1) & 0x0F);
+	}
+	return true;
+}
+
+static void rgb_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	memset(data, 0, (size_t)dataSize);
+}
+
+static void rgb_report(EmuDevice* dev)
+{
+	EmuLcdRgb* this = (EmuLcdRgb*)dev->State;
+
+	// PWM0..2 drive blue, green and red
+	fprintf(stderr, "           %u register writes, color R%u G%u B%u\n", this->Writes, this->Regs[4], this->Regs[3], this->Regs[2]);
+}
+
+EmuDevice* EmuLcdRgb_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuLcdRgb* this = (EmuLcdRgb*)calloc(1, sizeof(EmuLcdRgb));
+
+	dev->Address = LCD_RGB_ADDRESS;
+	dev->Name = "LCD-RGB";
+	dev->State = this;
+	dev->Write = rgb_write;
+	dev->Read = rgb_read;
+	dev->Report = rgb_report;
+
+	return dev;
+}
@@ -0,0 +1,148 @@
+#include "Devices.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SH1107G 128x128 1bpp OLED controller as used on the Grove OLED Display 1.12" V2.
+// Only page addressing and data writes are modelled; other commands are parsed and ignored.
+
+#define SH1107G_ADDRESS		0x3C
+
+#define CTRL_CO				0x80
+#define CTRL_DC				0x40
+
+#define RAM_COLUMNS			128
+#define RAM_PAGES			16		// eight pixel rows per byte
+
+typedef struct
+{
+	uint8_t Ram[RAM_PAGES][RAM_COLUMNS];
+
+	uint8_t Page;
+	uint8_t Column;
+
+	bool ParamPending;
+
+	uint32_t Commands;
+	uint32_t AddressCommands;
+	uint64_t DataBytes;
+}
+EmuSH1107G;
+
+static bool has_param(uint8_t cmd)
+{
+	switch (cmd)
+	{
+	case 0x81: case 0xA8: case 0xAD: case 0xD3: case 0xD5: case 0xD9: case 0xDB: case 0xDC:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void command_byte(EmuSH1107G* this, uint8_t b)
+{
+	if (this->ParamPending)
+	{
+		this->ParamPending = false;
+		return;
+	}
+
+	this->Commands++;
+	if (b <= 0x0F)
+	{
+		this->Column = (uint8_t)((this->Column & 0xF0) | b);
+		this->AddressCommands++;
+	}
+	else if (b >= 0x10 && b <= 0x17)
+	{
+		this->Column = (uint8_t)((this->Column & 0x0F) | (b & 0x07) << 4);
+		this->AddressCommands++;
+	}
+	else if (b >= 0xB0 && b <= 0xBF)
+	{
+		this->Page = b & 0x0F;
+		this->AddressCommands++;
+	}
+	else
+	{
+		this->ParamPending = has_param(b);
+	}
+}
+
+static void data_byte(EmuSH1107G* this, uint8_t b)
+{
+	this->DataBytes++;
+
+	this->Ram[this->Page][this->Column] = b;
+	this->Column = (uint8_t)((this->Column + 1) % RAM_COLUMNS);
+}
+
+static bool sh1107g_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuSH1107G* this = (EmuSH1107G*)dev->State;
+
+	int i = 0;
+	while (i < dataSize)
+	{
+		uint8_t control = data[i++];
+		bool single = (control & CTRL_CO) != 0;
+		bool isData = (control & CTRL_DC) != 0;
+
+		do
+		{
+			if (i >= dataSize) return true;
+			if (isData) data_byte(this, data[i]);
+			else command_byte(this, data[i]);
+			i++;
+		} while (!single);
+	}
+	return true;
+}
+
+static void sh1107g_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	memset(data, 0, (size_t)dataSize);
+}
+
+static void sh1107g_report(EmuDevice* dev)
+{
+	EmuSH1107G* this = (EmuSH1107G*)dev->State;
+
+	fprintf(stderr, "           %u commands (%u addressing), %llu GDDRAM bytes\n",
+		this->Commands, this->AddressCommands, (unsigned long long)this->DataBytes);
+}
+
+bool EmuSH1107G_SavePgm(EmuDevice* dev, const char* path)
+{
+	EmuSH1107G* this = (EmuSH1107G*)dev->State;
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) return false;
+
+	fprintf(file, "P5\n%d %d\n15\n", RAM_COLUMNS, RAM_PAGES * 8);
+	for (int row = 0; row < RAM_PAGES * 8; row++)
+	{
+		for (int column = 0; column < RAM_COLUMNS; column++)
+		{
+			// Bit 0 is the top row of the page
+			fputc((this->Ram[row / 8][column] >> (row % 8)) & 1 ? 15 : 0, file);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+EmuDevice* EmuSH1107G_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuSH1107G* this = (EmuSH1107G*)calloc(1, sizeof(EmuSH1107G));
+
+	dev->Address = SH1107G_ADDRESS;
+	dev->Name = "SH1107G";
+	dev->State = this;
+	dev->Write = sh1107g_write;
+	dev->Read = sh1107g_read;
+	dev->Report = sh1107g_report;
+
+	return dev;
+}
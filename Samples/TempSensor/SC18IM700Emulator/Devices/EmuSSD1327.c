@@ -0,0 +1,194 @@
+#include "Devices.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SSD1327 128x128 4bpp OLED controller as used on the Grove OLED Display 96x96.
+// Only addressing, remap, scroll and GDDRAM writes are modelled; other commands are parsed and ignored.
+
+#define SSD1327_ADDRESS		0x3C
+
+#define CTRL_CO				0x80
+#define CTRL_DC				0x40
+
+#define RAM_COLUMNS			64		// two pixels per byte
+#define RAM_ROWS			128
+
+typedef struct
+{
+	uint8_t Ram[RAM_ROWS][RAM_COLUMNS];
+
+	uint8_t ColumnStart, ColumnEnd, Column;
+	uint8_t RowStart, RowEnd, Row;
+	bool VerticalIncrement;
+	bool Scrolling;
+
+	uint8_t Command;
+	uint8_t Params[16];
+	int ParamCount;
+	int ParamsNeeded;
+
+	uint32_t Commands;
+	uint64_t DataBytes;
+	uint32_t ScrollViolations;
+}
+EmuSSD1327;
+
+static int param_count(uint8_t cmd)
+{
+	switch (cmd)
+	{
+	case 0x15: case 0x75:
+		return 2;
+	case 0x26: case 0x27:
+		return 7;
+	case 0xB8:
+		return 15;
+	case 0x81: case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xAB: case 0xB1: case 0xB3:
+	case 0xB6: case 0xBC: case 0xBE: case 0xD5: case 0xFD:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static void execute(EmuSSD1327* this)
+{
+	this->Commands++;
+
+	switch (this->Command)
+	{
+	case 0x15:
+		this->ColumnStart = this->Params[0] % RAM_COLUMNS;
+		this->ColumnEnd = this->Params[1] % RAM_COLUMNS;
+		this->Column = this->ColumnStart;
+		break;
+	case 0x75:
+		this->RowStart = this->Params[0] % RAM_ROWS;
+		this->RowEnd = this->Params[1] % RAM_ROWS;
+		this->Row = this->RowStart;
+		break;
+	case 0xA0:
+		this->VerticalIncrement = (this->Params[0] & 0x04) != 0;
+		break;
+	case 0x2F:
+		this->Scrolling = true;
+		break;
+	case 0x2E:
+		this->Scrolling = false;
+		break;
+	}
+}
+
+static void command_byte(EmuSSD1327* this, uint8_t b)
+{
+	if (this->ParamsNeeded > 0)
+	{
+		this->Params[this->ParamCount++] = b;
+		if (--this->ParamsNeeded == 0) execute(this);
+		return;
+	}
+
+	this->Command = b;
+	this->ParamCount = 0;
+	this->ParamsNeeded = param_count(b);
+	if (this->ParamsNeeded == 0) execute(this);
+}
+
+static void data_byte(EmuSSD1327* this, uint8_t b)
+{
+	this->DataBytes++;
+	if (this->Scrolling) this->ScrollViolations++;
+
+	this->Ram[this->Row][this->Column] = b;
+
+	if (this->VerticalIncrement)
+	{
+		if (this->Row++ >= this->RowEnd)
+		{
+			this->Row = this->RowStart;
+			if (this->Column++ >= this->ColumnEnd) this->Column = this->ColumnStart;
+		}
+	}
+	else
+	{
+		if (this->Column++ >= this->ColumnEnd)
+		{
+			this->Column = this->ColumnStart;
+			if (this->Row++ >= this->RowEnd) this->Row = this->RowStart;
+		}
+	}
+}
+
+static bool ssd1327_write(EmuDevice* dev, const uint8_t* data, int dataSize)
+{
+	EmuSSD1327* this = (EmuSSD1327*)dev->State;
+
+	int i = 0;
+	while (i < dataSize)
+	{
+		uint8_t control = data[i++];
+		bool single = (control & CTRL_CO) != 0;
+		bool isData = (control & CTRL_DC) != 0;
+
+		do
+		{
+			if (i >= dataSize) return true;
+			if (isData) data_byte(this, data[i]);
+			else command_byte(this, data[i]);
+			i++;
+		} while (!single);
+	}
+	return true;
+}
+
+static void ssd1327_read(EmuDevice* dev, uint8_t* data, int dataSize)
+{
+	memset(data, 0, (size_t)dataSize);
+}
+
+static void ssd1327_report(EmuDevice* dev)
+{
+	EmuSSD1327* this = (EmuSSD1327*)dev->State;
+
+	fprintf(stderr, "           %u commands, %llu GDDRAM bytes, %u writes while scrolling\n",
+		this->Commands, (unsigned long long)this->DataBytes, this->ScrollViolations);
+}
+
+bool EmuSSD1327_SavePgm(EmuDevice* dev, const char* path)
+{
+	EmuSSD1327* this = (EmuSSD1327*)dev->State;
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) return false;
+
+	fprintf(file, "P5\n%d %d\n15\n", RAM_COLUMNS * 2, RAM_ROWS);
+	for (int row = 0; row < RAM_ROWS; row++)
+	{
+		for (int column = 0; column < RAM_COLUMNS; column++)
+		{
+			// High nibble is the left pixel of the pair
+			fputc(this->Ram[row][column] >> 4, file);
+			fputc(this->Ram[row][column] & 0x0F, file);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+EmuDevice* EmuSSD1327_Create(void)
+{
+	EmuDevice* dev = (EmuDevice*)calloc(1, sizeof(EmuDevice));
+	EmuSSD1327* this = (EmuSSD1327*)calloc(1, sizeof(EmuSSD1327));
+
+	this->ColumnEnd = RAM_COLUMNS - 1;
+	this->RowEnd = RAM_ROWS - 1;
+
+	dev->Address = SSD1327_ADDRESS;
+	dev->Name = "SSD1327";
+	dev->State = this;
+	dev->Write = ssd1327_write;
+	dev->Read = ssd1327_read;
+	dev->Report = ssd1327_report;
+
+	return dev;
+}
@@ -0,0 +1,352 @@
+#include "Emulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REG_BRG0		0x00
+#define REG_BRG1		0x01
+#define REG_I2CCLKL		0x07
+#define REG_I2CCLKH		0x08
+#define REG_I2CTO		0x09
+#define REG_I2CSTAT		0x0A
+#define REG_COUNT		0x0B
+
+#define MAX_FRAME		(3 + 255)
+
+typedef enum
+{
+	State_Idle,
+	State_StartAddress,
+	State_StartLength,
+	State_StartData,
+	State_StartNext,		// after a complete S frame: 'S' (repeated start) or 'P'
+	State_ReadRegs,
+	State_WriteReg,
+	State_WriteValue,
+}
+ParseState;
+
+typedef struct
+{
+	uint64_t Commands;
+	uint64_t I2cWrites;
+	uint64_t I2cReads;
+	uint64_t RegReads;
+	uint64_t RegWrites;
+	uint64_t StatusPolls;
+	uint64_t DroppedBytes;
+	uint64_t CorruptedBytes;
+	uint64_t BaudChanges;
+}
+EmuCounters;
+
+struct Emulator
+{
+	void(*Transmit)(void* context, const uint8_t* data, int dataSize);
+	void* Context;
+
+	EmuDevice* Devices[EMU_MAX_DEVICES];
+	int DeviceCount;
+
+	uint8_t Regs[REG_COUNT];
+	uint32_t Baud;
+	uint32_t MaxReliableBaud;
+	uint32_t NoiseSeed;
+
+	ParseState State;
+	uint8_t Address;
+	int Length;
+	int DataCount;
+	uint8_t Data[MAX_FRAME];
+	uint8_t Reg;
+	bool BaudDirty;
+
+	uint64_t WireNs;
+	EmuCounters Counters;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Timing
+
+static uint64_t byte_ns(uint32_t baud)
+{
+	// 8N1: start + 8 data + stop
+	return 10ULL * 1000000000ULL / baud;
+}
+
+static uint64_t i2c_byte_ns(const Emulator* emu)
+{
+	uint32_t div = 2u * ((uint32_t)emu->Regs[REG_I2CCLKL] + emu->Regs[REG_I2CCLKH]);
+	if (div == 0) div = 1;
+	uint32_t i2cHz = EMU_CLOCK_HZ / div;
+
+	// 8 data bits + ACK
+	return 9ULL * 1000000000ULL / i2cHz;
+}
+
+static void update_baud(Emulator* emu)
+{
+	uint32_t brg = (uint32_t)emu->Regs[REG_BRG1] << 8 | emu->Regs[REG_BRG0];
+	uint32_t baud = EMU_CLOCK_HZ / (16 + brg);
+	if (baud != emu->Baud)
+	{
+		emu->Baud = baud;
+		emu->Counters.BaudChanges++;
+	}
+}
+
+static void transmit(Emulator* emu, const uint8_t* data, int dataSize)
+{
+	emu->WireNs += (uint64_t)dataSize * byte_ns(emu->Baud);
+	emu->Transmit(emu->Context, data, dataSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// I2C
+
+static EmuDevice* find_device(Emulator* emu, uint8_t address7)
+{
+	for (int i = 0; i < emu->DeviceCount; i++)
+	{
+		if (emu->Devices[i]->Address == address7) return emu->Devices[i];
+	}
+	return NULL;
+}
+
+static void run_frame(Emulator* emu)
+{
+	EmuDevice* dev = find_device(emu, emu->Address >> 1);
+
+	// Address byte plus payload on the I2C wire
+	emu->WireNs += (uint64_t)(1 + emu->Length) * i2c_byte_ns(emu);
+
+	if (dev == NULL)
+	{
+		emu->Regs[REG_I2CSTAT] = EMU_I2C_NACK_ON_ADDRESS;
+		return;
+	}
+
+	dev->Transactions++;
+	if (emu->Address & 0x01)
+	{
+		emu->Counters.I2cReads++;
+		uint8_t data[255];
+		dev->Read(dev, data, emu->Length);
+		dev->BytesRead += (uint64_t)emu->Length;
+		emu->Regs[REG_I2CSTAT] = EMU_I2C_OK;
+		transmit(emu, data, emu->Length);
+	}
+	else
+	{
+		emu->Counters.I2cWrites++;
+		dev->BytesWritten += (uint64_t)emu->Length;
+		emu->Regs[REG_I2CSTAT] = dev->Write(dev, emu->Data, emu->Length) ? EMU_I2C_OK : EMU_I2C_NACK_ON_DATA;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parser
+
+static void receive_byte(Emulator* emu, uint8_t b)
+{
+	switch (emu->State)
+	{
+	case State_Idle:
+	case State_StartNext:
+		if (b == 'S')
+		{
+			if (emu->State == State_Idle) emu->Counters.Commands++;
+			emu->State = State_StartAddress;
+		}
+		else if (b == 'P')
+		{
+			// Ends a frame sequence; a stray stop while idle is harmless
+			emu->State = State_Idle;
+		}
+		else if (b == 'R' && emu->State == State_Idle)
+		{
+			emu->Counters.Commands++;
+			emu->State = State_ReadRegs;
+		}
+		else if (b == 'W' && emu->State == State_Idle)
+		{
+			emu->Counters.Commands++;
+			emu->State = State_WriteReg;
+		}
+		else
+		{
+			// Unknown command byte: the real part ignores it until the next command
+			emu->Counters.DroppedBytes++;
+			emu->State = State_Idle;
+		}
+		break;
+
+	case State_StartAddress:
+		emu->Address = b;
+		emu->State = State_StartLength;
+		break;
+
+	case State_StartLength:
+		emu->Length = b;
+		emu->DataCount = 0;
+		if ((emu->Address & 0x01) || emu->Length == 0)
+		{
+			run_frame(emu);
+			emu->State = State_StartNext;
+		}
+		else
+		{
+			emu->State = State_StartData;
+		}
+		break;
+
+	case State_StartData:
+		emu->Data[emu->DataCount++] = b;
+		if (emu->DataCount == emu->Length)
+		{
+			run_frame(emu);
+			emu->State = State_StartNext;
+		}
+		break;
+
+	case State_ReadRegs:
+		if (b == 'P')
+		{
+			emu->State = State_Idle;
+			break;
+		}
+		emu->Counters.RegReads++;
+		if (b == REG_I2CSTAT) emu->Counters.StatusPolls++;
+		{
+			uint8_t value = b < REG_COUNT ? emu->Regs[b] : 0x00;
+			transmit(emu, &value, 1);
+		}
+		break;
+
+	case State_WriteReg:
+		if (b == 'P')
+		{
+			emu->State = State_Idle;
+			// A new baud rate takes effect once the command has completed
+			if (emu->BaudDirty) update_baud(emu);
+			emu->BaudDirty = false;
+			break;
+		}
+		emu->Reg = b;
+		emu->State = State_WriteValue;
+		break;
+
+	case State_WriteValue:
+		emu->Counters.RegWrites++;
+		if (emu->Reg < REG_COUNT && emu->Reg != REG_I2CSTAT) emu->Regs[emu->Reg] = b;
+		if (emu->Reg == REG_BRG0 || emu->Reg == REG_BRG1) emu->BaudDirty = true;
+		emu->State = State_WriteReg;
+		break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Emulator
+
+Emulator* Emulator_Create(void(*transmit)(void* context, const uint8_t* data, int dataSize), void* context)
+{
+	Emulator* emu = (Emulator*)calloc(1, sizeof(Emulator));
+	if (emu == NULL) return NULL;
+
+	emu->Transmit = transmit;
+	emu->Context = context;
+
+	// Power-on defaults: 9600 baud, ~97 kHz I2C
+	emu->Regs[REG_BRG0] = 0xF0;
+	emu->Regs[REG_BRG1] = 0x02;
+	emu->Regs[REG_I2CCLKL] = 0x13;
+	emu->Regs[REG_I2CCLKH] = 0x13;
+	emu->Regs[REG_I2CTO] = 0x66;
+	emu->Regs[REG_I2CSTAT] = EMU_I2C_OK;
+	update_baud(emu);
+	emu->Counters.BaudChanges = 0;
+
+	return emu;
+}
+
+void Emulator_Destroy(Emulator* emu)
+{
+	free(emu);
+}
+
+bool Emulator_AddDevice(Emulator* emu, EmuDevice* dev)
+{
+	if (emu->DeviceCount >= EMU_MAX_DEVICES || find_device(emu, dev->Address) != NULL) return false;
+
+	emu->Devices[emu->DeviceCount++] = dev;
+	return true;
+}
+
+void Emulator_Receive(Emulator* emu, const uint8_t* data, int dataSize, uint32_t lineBaud)
+{
+	if (lineBaud != emu->Baud)
+	{
+		emu->Counters.DroppedBytes += (uint64_t)dataSize;
+		return;
+	}
+
+	bool noisy = emu->MaxReliableBaud != 0 && emu->Baud > emu->MaxReliableBaud;
+	for (int i = 0; i < dataSize; i++)
+	{
+		uint8_t b = data[i];
+		if (noisy)
+		{
+			emu->NoiseSeed = emu->NoiseSeed * 1103515245u + 12345u;
+			if (((emu->NoiseSeed >> 16) & 0x1F) == 0)
+			{
+				b ^= (uint8_t)(1u << ((emu->NoiseSeed >> 24) & 7));
+				emu->Counters.CorruptedBytes++;
+			}
+		}
+
+		emu->WireNs += byte_ns(emu->Baud);
+		receive_byte(emu, b);
+	}
+}
+
+uint32_t Emulator_GetBaudRate(const Emulator* emu)
+{
+	return emu->Baud;
+}
+
+void Emulator_SetMaxReliableBaud(Emulator* emu, uint32_t maxBaud)
+{
+	emu->MaxReliableBaud = maxBaud;
+	emu->NoiseSeed = 1;
+}
+
+uint64_t Emulator_GetWireTime(const Emulator* emu)
+{
+	return emu->WireNs;
+}
+
+void Emulator_SyncWireTime(Emulator* emu, uint64_t nowNs)
+{
+	// An idle line does not bank time
+	if (emu->WireNs < nowNs) emu->WireNs = nowNs;
+}
+
+void Emulator_Report(const Emulator* emu)
+{
+	const EmuCounters* c = &emu->Counters;
+
+	fprintf(stderr, "SC18IM700: %u baud, %llu commands, %llu I2C writes, %llu I2C reads, %llu register reads (%llu status polls), %llu register writes, %llu baud changes, %llu dropped bytes, %llu corrupted bytes\n",
+		emu->Baud,
+		(unsigned long long)c->Commands, (unsigned long long)c->I2cWrites, (unsigned long long)c->I2cReads,
+		(unsigned long long)c->RegReads, (unsigned long long)c->StatusPolls, (unsigned long long)c->RegWrites,
+		(unsigned long long)c->BaudChanges, (unsigned long long)c->DroppedBytes, (unsigned long long)c->CorruptedBytes);
+
+	for (int i = 0; i < emu->DeviceCount; i++)
+	{
+		EmuDevice* dev = emu->Devices[i];
+		fprintf(stderr, "  0x%02X %-8s %6u transactions, %8llu bytes written, %8llu bytes read\n",
+			dev->Address, dev->Name, dev->Transactions,
+			(unsigned long long)dev->BytesWritten, (unsigned long long)dev->BytesRead);
+		if (dev->Report != NULL) dev->Report(dev);
+	}
+}
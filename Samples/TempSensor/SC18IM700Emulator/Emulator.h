@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// SC18IM700 UART-to-I2C bridge emulator.
+// Bytes from the host are fed in with Emulator_Receive(); responses are handed to the Transmit callback.
+// Serial and I2C wire time are modelled on a virtual clock so callers can pace their output.
+
+#define EMU_MAX_DEVICES		8
+
+#define EMU_I2C_OK					0xF0
+#define EMU_I2C_NACK_ON_ADDRESS		0xF1
+#define EMU_I2C_NACK_ON_DATA		0xF2
+#define EMU_I2C_TIME_OUT			0xF8
+
+#define EMU_CLOCK_HZ				7372800
+
+typedef struct EmuDevice EmuDevice;
+
+struct EmuDevice
+{
+	uint8_t Address;		// 7-bit
+	const char* Name;
+	void* State;
+
+	// Write returns false to NACK; Read fills exactly dataSize bytes.
+	bool(*Write)(EmuDevice* dev, const uint8_t* data, int dataSize);
+	void(*Read)(EmuDevice* dev, uint8_t* data, int dataSize);
+	void(*Report)(EmuDevice* dev);
+
+	uint64_t BytesWritten;
+	uint64_t BytesRead;
+	uint32_t Transactions;
+};
+
+typedef struct Emulator Emulator;
+
+Emulator* Emulator_Create(void(*transmit)(void* context, const uint8_t* data, int dataSize), void* context);
+void Emulator_Destroy(Emulator* emu);
+
+bool Emulator_AddDevice(Emulator* emu, EmuDevice* dev);
+
+// Feeds bytes received at lineBaud. Bytes sent at any other rate are garbage to the bridge and are dropped.
+void Emulator_Receive(Emulator* emu, const uint8_t* data, int dataSize, uint32_t lineBaud);
+
+uint32_t Emulator_GetBaudRate(const Emulator* emu);
+
+// Models a marginal line: above maxBaud roughly one received byte in 32 has a bit flipped. 0 disables.
+void Emulator_SetMaxReliableBaud(Emulator* emu, uint32_t maxBaud);
+
+// Virtual time (ns) at which the last byte queued so far has left the bridge.
+uint64_t Emulator_GetWireTime(const Emulator* emu);
+void Emulator_SyncWireTime(Emulator* emu, uint64_t nowNs);
+
+void Emulator_Report(const Emulator* emu);
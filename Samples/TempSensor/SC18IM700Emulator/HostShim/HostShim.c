@@ -0,0 +1,66 @@
+#include <applibs/uart.h>
+#include <applibs/gpio.h>
+#include <applibs/log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../Serial.h"
+
+void UART_InitConfig(UART_Config* uartConfig)
+{
+	memset(uartConfig, 0, sizeof(*uartConfig));
+	uartConfig->baudRate = 9600;
+	uartConfig->blockingMode = UART_BlockingMode_NonBlocking;
+	uartConfig->dataBits = 8;
+}
+
+int UART_Open(UART_Id uartId, const UART_Config* uartConfig)
+{
+	const char* path = getenv("GROVE_UART_DEVICE");
+	if (path == NULL) path = "/tmp/sc18im700";
+
+	int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0) return -1;
+
+	if (!Serial_SetRaw(fd, uartConfig->baudRate))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int GPIO_OpenAsOutput(GPIO_Id gpioId, GPIO_OutputMode_Type outputMode, GPIO_Value_Type initialValue)
+{
+	return open("/dev/null", O_RDWR);
+}
+
+int GPIO_OpenAsInput(GPIO_Id gpioId)
+{
+	return open("/dev/null", O_RDONLY);
+}
+
+int GPIO_SetValue(int gpioFd, GPIO_Value_Type value)
+{
+	return 0;
+}
+
+int GPIO_GetValue(int gpioFd, GPIO_Value_Type* outValue)
+{
+	*outValue = GPIO_Value_High;
+	return 0;
+}
+
+int Log_Debug(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	int result = vfprintf(stderr, fmt, args);
+	va_end(args);
+	return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for the Azure Sphere applibs GPIO API. Outputs are discarded, inputs read high.
+
+typedef int GPIO_Id;
+typedef int GPIO_Value_Type;
+typedef int GPIO_OutputMode_Type;
+
+#define GPIO_Value_Low				0
+#define GPIO_Value_High				1
+
+#define GPIO_OutputMode_PushPull	0
+#define GPIO_OutputMode_OpenDrain	1
+#define GPIO_OutputMode_OpenSource	2
+
+int GPIO_OpenAsOutput(GPIO_Id gpioId, GPIO_OutputMode_Type outputMode, GPIO_Value_Type initialValue);
+int GPIO_OpenAsInput(GPIO_Id gpioId);
+int GPIO_SetValue(int gpioFd, GPIO_Value_Type value);
+int GPIO_GetValue(int gpioFd, GPIO_Value_Type* outValue);
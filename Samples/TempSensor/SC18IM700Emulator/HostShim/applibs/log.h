@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for the Azure Sphere applibs log API: writes to stderr.
+
+int Log_Debug(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
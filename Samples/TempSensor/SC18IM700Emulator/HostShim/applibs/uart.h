@@ -0,0 +1,27 @@
+#pragma once
+
+// Host stand-in for the Azure Sphere applibs UART API. UART_Open() opens the serial device named by
+// the GROVE_UART_DEVICE environment variable (default /tmp/sc18im700), e.g. the emulator's pty.
+
+#include <stdint.h>
+
+typedef int UART_Id;
+typedef uint32_t UART_BaudRate_Type;
+typedef uint8_t UART_BlockingMode_Type;
+
+#define UART_BlockingMode_NonBlocking	((UART_BlockingMode_Type)0)
+
+typedef struct
+{
+	uint32_t z__magicAndVersion;
+	UART_BaudRate_Type baudRate;
+	UART_BlockingMode_Type blockingMode;
+	uint8_t dataBits;
+	uint8_t parity;
+	uint8_t stopBits;
+	uint8_t flowControl;
+}
+UART_Config;
+
+void UART_InitConfig(UART_Config* uartConfig);
+int UART_Open(UART_Id uartId, const UART_Config* uartConfig);
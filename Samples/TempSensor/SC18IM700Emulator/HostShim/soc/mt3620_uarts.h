@@ -0,0 +1,6 @@
+#pragma once
+
+#define MT3620_UART_ISU0	4
+#define MT3620_UART_ISU1	5
+#define MT3620_UART_ISU2	6
+#define MT3620_UART_ISU3	7
@@ -0,0 +1,30 @@
+// <asm/termbits.h> clashes with <termios.h>, so this file is the only place that touches termios.
+#include "Serial.h"
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+
+bool Serial_SetRaw(int fd, uint32_t baud)
+{
+	struct termios2 tio;
+	if (ioctl(fd, TCGETS2, &tio) != 0) return false;
+
+	tio.c_iflag = 0;
+	tio.c_oflag = 0;
+	tio.c_lflag = 0;
+	tio.c_cflag = CS8 | CREAD | CLOCAL | BOTHER;
+	tio.c_cflag |= (BOTHER << IBSHIFT);
+	tio.c_ispeed = baud;
+	tio.c_ospeed = baud;
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+
+	return ioctl(fd, TCSETS2, &tio) == 0;
+}
+
+uint32_t Serial_GetBaud(int fd)
+{
+	struct termios2 tio;
+	if (ioctl(fd, TCGETS2, &tio) != 0) return 0;
+
+	return tio.c_ospeed;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// termios2 helpers so arbitrary rates such as 460800 or 307200 survive the trip through a pty.
+
+bool Serial_SetRaw(int fd, uint32_t baud);
+uint32_t Serial_GetBaud(int fd);
@@ -0,0 +1,177 @@
+// Decoder for GroveI2CTrace capture files.
+//
+//   grove-trace-dump [-v] capture.bin
+//
+// Prints a per-device summary ordered by bus time; -v also lists every transaction with its payload.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_DEVICES		128
+
+typedef struct
+{
+	uint8_t Address;
+	uint32_t Transactions;
+	uint32_t Failures;
+	uint32_t Writes;
+	uint32_t Reads;
+	uint32_t WriteReads;
+	uint64_t BytesWritten;
+	uint64_t BytesRead;
+	uint64_t StatusPolls;
+	uint64_t BusUs;
+	uint32_t MaxUs;
+}
+DeviceSummary;
+
+static uint16_t read_u16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t* p)
+{
+	return (uint32_t)read_u16(p) | (uint32_t)read_u16(p + 2) << 16;
+}
+
+static int CompareBusTime(const void* a, const void* b)
+{
+	uint64_t x = ((const DeviceSummary*)a)->BusUs;
+	uint64_t y = ((const DeviceSummary*)b)->BusUs;
+	return (x < y) - (x > y);
+}
+
+static void PrintPayload(const char* label, const uint8_t* data, int size)
+{
+	if (size == 0) return;
+
+	printf("  %s", label);
+	for (int i = 0; i < size && i < 16; i++) printf(" %02X", data[i]);
+	if (size > 16) printf(" ... (%d bytes)", size);
+}
+
+int main(int argc, char* argv[])
+{
+	bool verbose = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "v")) != -1)
+	{
+		switch (opt)
+		{
+		case 'v': verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-v] capture.bin\n", argv[0]);
+			return 2;
+		}
+	}
+	if (optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-v] capture.bin\n", argv[0]);
+		return 2;
+	}
+
+	FILE* file = fopen(argv[optind], "rb");
+	if (file == NULL)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	uint8_t header[8];
+	if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "GI2CTRC", 7) != 0 || header[7] != 1)
+	{
+		fprintf(stderr, "%s: not a version 1 GroveI2CTrace capture\n", argv[optind]);
+		return 1;
+	}
+
+	DeviceSummary devices[MAX_DEVICES];
+	int deviceCount = 0;
+	uint64_t records = 0;
+	uint32_t firstUs = 0, lastUs = 0;
+
+	uint8_t record[16];
+	static uint8_t payload[2 * 65536];
+	while (fread(record, 1, sizeof(record), file) == sizeof(record))
+	{
+		uint32_t startUs = read_u32(&record[0]);
+		uint32_t latencyUs = read_u32(&record[4]);
+		uint8_t address = record[8];
+		char op = (char)record[9];
+		bool ok = record[10] != 0;
+		uint8_t polls = record[11];
+		int writeSize = read_u16(&record[12]);
+		int readSize = read_u16(&record[14]);
+
+		if (fread(payload, 1, (size_t)(writeSize + readSize), file) != (size_t)(writeSize + readSize))
+		{
+			fprintf(stderr, "truncated record at transaction %llu\n", (unsigned long long)records);
+			break;
+		}
+
+		if (records == 0) firstUs = startUs;
+		lastUs = startUs + latencyUs;
+		records++;
+
+		DeviceSummary* dev = NULL;
+		for (int i = 0; i < deviceCount && dev == NULL; i++)
+		{
+			if (devices[i].Address == address) dev = &devices[i];
+		}
+		if (dev == NULL && deviceCount < MAX_DEVICES)
+		{
+			dev = &devices[deviceCount++];
+			memset(dev, 0, sizeof(*dev));
+			dev->Address = address;
+		}
+		if (dev != NULL)
+		{
+			dev->Transactions++;
+			if (!ok) dev->Failures++;
+			if (op == 'W') dev->Writes++;
+			else if (op == 'R') dev->Reads++;
+			else dev->WriteReads++;
+			dev->BytesWritten += (uint64_t)writeSize;
+			dev->BytesRead += (uint64_t)readSize;
+			dev->StatusPolls += polls;
+			dev->BusUs += latencyUs;
+			if (latencyUs > dev->MaxUs) dev->MaxUs = latencyUs;
+		}
+
+		if (verbose)
+		{
+			printf("%10.3f ms  0x%02X %c %s %6u us %3u polls", startUs / 1000.0, address >> 1, op, ok ? "ok  " : "FAIL", latencyUs, polls);
+			PrintPayload("w", payload, writeSize);
+			PrintPayload("r", payload + writeSize, readSize);
+			printf("\n");
+		}
+	}
+	fclose(file);
+
+	qsort(devices, (size_t)deviceCount, sizeof(devices[0]), CompareBusTime);
+
+	uint64_t total = 0;
+	for (int i = 0; i < deviceCount; i++) total += devices[i].BusUs;
+
+	printf("%llu transactions over %.3f ms, %.3f ms on the bus\n\n",
+		(unsigned long long)records, (lastUs - firstUs) / 1000.0, total / 1000.0);
+	printf("%-6s %7s %9s %8s %8s %8s %11s %10s %9s %10s %9s\n",
+		"addr", "bus %", "trans", "writes", "reads", "w+r", "B out", "B in", "polls", "mean us", "max us");
+	for (int i = 0; i < deviceCount; i++)
+	{
+		const DeviceSummary* d = &devices[i];
+		printf("0x%02X   %7.1f %9u %8u %8u %8u %11llu %10llu %9llu %10.1f %9u\n",
+			d->Address >> 1, total > 0 ? 100.0 * (double)d->BusUs / (double)total : 0.0,
+			d->Transactions, d->Writes, d->Reads, d->WriteReads,
+			(unsigned long long)d->BytesWritten, (unsigned long long)d->BytesRead, (unsigned long long)d->StatusPolls,
+			(double)d->BusUs / d->Transactions, d->MaxUs);
+		if (d->Failures > 0) printf("       %u failed\n", d->Failures);
+	}
+
+	return 0;
+}
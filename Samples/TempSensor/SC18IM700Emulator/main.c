@@ -0,0 +1,194 @@
+// SC18IM700 bridge emulator on a pseudo-terminal.
+//
+//   sc18im700-emu [-l link] [-d bme280,ad7992,lcd,ssd1327|sh1107g] [-o frame.pgm] [-m max-baud] [-n]
+//
+// The pty slave is symlinked to `link` (default /tmp/sc18im700); point GROVE_UART_DEVICE at it when running
+// code built against HostShim. Responses are held back until the modelled UART/I2C wire time has passed,
+// unless -n is given. With -m the line corrupts
+// received bytes above max-baud, for exercising link tuning. SIGUSR1 prints the counters, SIGINT/SIGTERM print them and exit.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Emulator.h"
+#include "Serial.h"
+#include "Devices/Devices.h"
+
+static volatile sig_atomic_t terminationRequired = false;
+static volatile sig_atomic_t reportRequested = false;
+
+static int masterFd = -1;
+static bool modelTiming = true;
+static Emulator* emu;
+
+static void TerminationHandler(int signalNumber)
+{
+	terminationRequired = true;
+}
+
+static void ReportHandler(int signalNumber)
+{
+	reportRequested = true;
+}
+
+static void SleepUntil(uint64_t ns)
+{
+	struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+static void Transmit(void* context, const uint8_t* data, int dataSize)
+{
+	// The last byte leaves the bridge at the current wire time
+	if (modelTiming) SleepUntil(Emulator_GetWireTime(emu));
+
+	while (dataSize > 0)
+	{
+		ssize_t written = write(masterFd, data, (size_t)dataSize);
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			if (errno != EAGAIN) return;
+			struct pollfd pfd = { .fd = masterFd, .events = POLLOUT };
+			poll(&pfd, 1, 100);
+			continue;
+		}
+		data += written;
+		dataSize -= (int)written;
+	}
+}
+
+static bool AddDevices(Emulator* emu, const char* list, EmuDevice** oled, bool(**savePgm)(EmuDevice* dev, const char* path))
+{
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "%s", list);
+
+	for (char* name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ","))
+	{
+		if (strcmp(name, "bme280") == 0) Emulator_AddDevice(emu, EmuBME280_Create());
+		else if (strcmp(name, "ad7992") == 0) Emulator_AddDevice(emu, EmuAD7992_Create());
+		else if (strcmp(name, "lcd") == 0)
+		{
+			Emulator_AddDevice(emu, EmuLcdText_Create());
+			Emulator_AddDevice(emu, EmuLcdRgb_Create());
+		}
+		else if (strcmp(name, "ssd1327") == 0)
+		{
+			*oled = EmuSSD1327_Create();
+			*savePgm = EmuSSD1327_SavePgm;
+			Emulator_AddDevice(emu, *oled);
+		}
+		else if (strcmp(name, "sh1107g") == 0)
+		{
+			*oled = EmuSH1107G_Create();
+			*savePgm = EmuSH1107G_SavePgm;
+			Emulator_AddDevice(emu, *oled);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown device '%s'\n", name);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* link = "/tmp/sc18im700";
+	const char* devices = "bme280,ad7992,lcd,ssd1327";
+	const char* pgmPath = NULL;
+	uint32_t maxReliableBaud = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:d:o:m:n")) != -1)
+	{
+		switch (opt)
+		{
+		case 'l': link = optarg; break;
+		case 'd': devices = optarg; break;
+		case 'o': pgmPath = optarg; break;
+		case 'm': maxReliableBaud = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'n': modelTiming = false; break;
+		default:
+			fprintf(stderr, "usage: %s [-l link] [-d bme280,ad7992,lcd,ssd1327|sh1107g] [-o frame.pgm] [-m max-baud] [-n]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = TerminationHandler;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+	action.sa_handler = ReportHandler;
+	sigaction(SIGUSR1, &action, NULL);
+
+	masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+	{
+		perror("posix_openpt");
+		return 1;
+	}
+	fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+	// Holding the slave open keeps the master readable across client reconnects and lets us see the client's baud rate
+	const char* slavePath = ptsname(masterFd);
+	int slaveFd = open(slavePath, O_RDWR | O_NOCTTY);
+	if (slaveFd < 0 || !Serial_SetRaw(slaveFd, 9600))
+	{
+		perror(slavePath);
+		return 1;
+	}
+
+	unlink(link);
+	if (symlink(slavePath, link) != 0)
+	{
+		perror(link);
+		return 1;
+	}
+
+	EmuDevice* oled = NULL;
+	bool(*savePgm)(EmuDevice* dev, const char* path) = NULL;
+	emu = Emulator_Create(Transmit, NULL);
+	if (!AddDevices(emu, devices, &oled, &savePgm)) return 2;
+	Emulator_SetMaxReliableBaud(emu, maxReliableBaud);
+
+	fprintf(stderr, "SC18IM700 emulator on %s -> %s (%s)\n", link, slavePath, devices);
+
+	while (!terminationRequired)
+	{
+		if (reportRequested)
+		{
+			reportRequested = false;
+			Emulator_Report(emu);
+		}
+
+		struct pollfd pfd = { .fd = masterFd, .events = POLLIN };
+		if (poll(&pfd, 1, 200) <= 0) continue;
+
+		uint8_t buffer[4096];
+		ssize_t readSize = read(masterFd, buffer, sizeof(buffer));
+		if (readSize <= 0) continue;
+
+		Emulator_SyncWireTime(emu, Emu_NowNs());
+		Emulator_Receive(emu, buffer, (int)readSize, Serial_GetBaud(slaveFd));
+	}
+
+	Emulator_Report(emu);
+	if (pgmPath != NULL && oled != NULL && !savePgm(oled, pgmPath)) perror(pgmPath);
+
+	unlink(link);
+	close(slaveFd);
+	close(masterFd);
+	Emulator_Destroy(emu);
+
+	return 0;
+}
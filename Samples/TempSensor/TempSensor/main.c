@@ -8,6 +8,7 @@
 
 #include <Hal\GroveShield.h>
 #include <sensors\GroveLcdRgbBacklight.h>
+#include <sensors\GroveAD7992.h>
 
 // applibs_versions.h defines the API struct versions to use for applibs APIs.
 #include "applibs_versions.h"
@@ -35,9 +36,13 @@ static int gpioButtonFd = -1;
 static int gpioButtonTimerFd = -1;
 static int gpioLedFd = -1;
 static int gpioLedTimerFd = -1;
+static int adcAlertTimerFd = -1;
+static int backlightTimerFd = -1;
 static int epollFd = -1;
 
 static struct dht11 tempSensor;
+static void *adc = NULL;
+static void *lcd = NULL;
 
 // Button state variables
 static GPIO_Value_Type buttonState = GPIO_Value_High;
@@ -48,6 +53,10 @@ static const int numBlinkIntervals = 3;
 static const struct timespec blinkIntervals[] = {{0, 125000000}, {0, 250000000}, {0, 500000000}};
 static int blinkIntervalIndex = 0;
 
+// Backlight animation steps; the timer is only armed while an animation runs
+static const struct timespec backlightStepPeriod = {0, 20000000};
+static const struct timespec timerDisarmed = {0, 0};
+
 // Termination state
 static volatile sig_atomic_t terminationRequired = false;
 
@@ -108,13 +117,61 @@ static void ButtonTimerEventHandler()
                 terminationRequired = true;
             }*/
 
+            // Show the reading; the LCD only receives the characters that changed
             struct measurement sample;
-            Measure(&tempSensor, &sample);
+            if (Measure(&tempSensor, &sample) > 0) {
+                GroveLcdRgbBacklight_Printf(lcd, 0, 0, "Temp %3u C", sample.temperature);
+                GroveLcdRgbBacklight_Printf(lcd, 1, 0, "RH   %3u %%", sample.humidity);
+                GroveLcdRgbBacklight_Update(lcd);
+            }
         }
         buttonState = newButtonState;
     }
 }
 
+/// <summary>
+///     Light level (AD7992 VIN1) crossed one of its limits.
+/// </summary>
+static void LightAlertHandler(void *context, int channel, GroveAD7992_Alert alert)
+{
+    Log_Debug("Light level on VIN%d went %s its window\n", channel + 1,
+              alert == GroveAD7992_Alert_High ? "above" : "below");
+
+    // Flash the backlight three times, then it returns to its resting color
+    GroveLcdRgbBacklight_Flash(lcd, 255, 96, 0, 150, 150, 3);
+    SetTimerFdInterval(backlightTimerFd, &backlightStepPeriod);
+}
+
+/// <summary>
+///     Handle backlight timer event: advance the backlight animation, and stop the timer once it is over.
+/// </summary>
+static void BacklightTimerEventHandler()
+{
+    if (ConsumeTimerFdEvent(backlightTimerFd) != 0) {
+        terminationRequired = true;
+        return;
+    }
+
+    if (!GroveLcdRgbBacklight_Animate(lcd)) {
+        SetTimerFdInterval(backlightTimerFd, &timerDisarmed);
+    }
+}
+
+/// <summary>
+///     Handle ADC alert timer event: check the AD7992 ALERT pin, which only costs I2C traffic on a crossing.
+/// </summary>
+static void AdcAlertTimerEventHandler()
+{
+    if (ConsumeTimerFdEvent(adcAlertTimerFd) != 0) {
+        terminationRequired = true;
+        return;
+    }
+
+    if (GroveAD7992_PollAlerts(adc) < 0) {
+        Log_Debug("ERROR: Could not read the AD7992 alert state.\n");
+    }
+}
+
 /// <summary>
 ///     Set up SIGTERM termination handler, initialize peripherals, and set up event handlers.
 /// </summary>
@@ -167,10 +224,39 @@ static int InitPeripheralsAndHandlers(void)
         return -1;
     }
 
-    int groveFd;
-    GroveShield_Initialize(&groveFd, 115200);
-    void *lcd = GroveLcdRgbBacklight_Open(groveFd);
-    GroveLcdRgbBacklight_SetBacklightRgb(lcd, 30, 156, 142);
+    int groveFd = -1;
+    // Bring the shield up and run the link as fast as it stays clean
+    if (!GroveShield_TuneLink(&groveFd, 460800, NULL)) {
+        GroveShield_Initialize(&groveFd, 115200);
+    }
+    lcd = GroveLcdRgbBacklight_Open(groveFd);
+
+    // Fade the backlight in, stepped from the event loop
+    GroveLcdRgbBacklight_FadeTo(lcd, 30, 156, 142, 1000, GroveLcdRgbBacklight_Ease_InOut);
+    backlightTimerFd = CreateTimerFdAndAddToEpoll(epollFd, &backlightStepPeriod,
+                                                  &BacklightTimerEventHandler, EPOLLIN);
+    if (backlightTimerFd < 0) {
+        return -1;
+    }
+
+    // Let the ADC watch the light sensor on its own and poll the ALERT pin every 10 ms
+    adc = GroveAD7992_Open(groveFd);
+    if (adc == NULL) {
+        Log_Debug("ERROR: Could not open the AD7992.\n");
+        return -1;
+    }
+    GroveAD7992_SetLimits(adc, 0, 400, 3600, 100);
+    if (!GroveAD7992_StartAlerts(adc, GroveAD7992_Channel_1, GroveAD7992_Cycle_X2048, &LightAlertHandler, NULL)) {
+        // Without the ALERT pin the app runs on, just without light alerts
+        Log_Debug("WARNING: AD7992 alerts unavailable, light level is not watched.\n");
+    } else {
+        struct timespec adcAlertCheckPeriod = {0, 10000000};
+        adcAlertTimerFd = CreateTimerFdAndAddToEpoll(epollFd, &adcAlertCheckPeriod,
+                                                     &AdcAlertTimerEventHandler, EPOLLIN);
+        if (adcAlertTimerFd < 0) {
+            return -1;
+        }
+    }
 
     return 0;
 }
@@ -190,6 +276,8 @@ static void ClosePeripheralsAndHandlers(void)
     CloseFdAndPrintError(gpioLedFd, "GpioLed");
     CloseFdAndPrintError(gpioButtonTimerFd, "ButtonTimer");
     CloseFdAndPrintError(gpioButtonFd, "GpioButton");
+    CloseFdAndPrintError(adcAlertTimerFd, "AdcAlertTimer");
+    CloseFdAndPrintError(backlightTimerFd, "BacklightTimer");
     CloseFdAndPrintError(epollFd, "Epoll");
 }
 